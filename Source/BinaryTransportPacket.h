@@ -0,0 +1,240 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "OSCTransportMessage.h"
+
+/**
+ * @struct BinaryTransportPacket
+ * @brief Compact fixed-layout alternative to the OSC transport messages, for
+ *        high-rate links. One 36-byte little-endian datagram per update:
+ *
+ *            offset  size  field
+ *                 0     4  magic "TSBP" (never '/' or '#', so OSC parsers reject it)
+ *                 4     1  version
+ *                 5     1  sender's stream ID, 0 = none (receivers route on it)
+ *                 6     2  flags (bit 0 = playing)
+ *                 8     4  sequence number, wraps
+ *                12     8  position in ticks (ticksPerQuarterNote per quarter), signed
+ *                20     8  tempo in BPM, IEEE double
+ *                28     8  host timestamp in nanoseconds
+ *
+ *        When the hasContext flag is set, a 36-byte TransportContext extension
+ *        follows (72 bytes in all). Receivers that only know the base layout
+ *        read the first 36 bytes and ignore the rest:
+ *
+ *                36     1  time signature numerator
+ *                37     1  time signature denominator
+ *                38     2  reserved, 0
+ *                40     8  loop start in ticks
+ *                48     8  loop end in ticks
+ *                56     8  bar start in ticks
+ *                64     4  bar count, signed (-1 = unknown)
+ *                68     4  frame rate in thousandths of a frame per second (0 = unknown)
+ *
+ *        encode() and decode() are a handful of fixed stores and loads, with
+ *        no parsing, no strings and no allocation.
+ */
+struct BinaryTransportPacket
+{
+    static constexpr size_t size = 36;
+    static constexpr size_t sizeWithContext = 72;
+    static constexpr uint8_t currentVersion = 1;
+    static constexpr int64_t ticksPerQuarterNote = 960000;
+
+    enum Flags : uint16_t
+    {
+        isPlayingFlag   = 1 << 0,
+        hasContextFlag  = 1 << 1,   // The extension is present
+        isLoopingFlag   = 1 << 2,
+        isRecordingFlag = 1 << 3,
+        isDropFrameFlag = 1 << 4
+    };
+
+    uint8_t streamId = 0;                   // TransportStream::getStreamId() of the sender, if it fits
+    uint16_t flags = 0;
+    uint32_t sequence = 0;
+    int64_t tickPosition = 0;
+    double tempo = 120.0;
+    uint64_t hostTimeNs = 0;
+    TransportContext context;               // Only meaningful with hasContext()
+
+    bool isPlaying() const noexcept         { return (flags & isPlayingFlag) != 0; }
+    bool hasContext() const noexcept        { return (flags & hasContextFlag) != 0; }
+    size_t getEncodedSize() const noexcept  { return hasContext() ? sizeWithContext : size; }
+    double getPpqPosition() const noexcept  { return ticksToPpq(tickPosition); }
+
+    static int64_t ppqToTicks(double ppq) noexcept
+    {
+        return static_cast<int64_t>(std::llround(ppq * static_cast<double>(ticksPerQuarterNote)));
+    }
+
+    static double ticksToPpq(int64_t ticks) noexcept
+    {
+        return static_cast<double>(ticks) / static_cast<double>(ticksPerQuarterNote);
+    }
+
+    // Sets the context and the flags that go with it; encode() then adds the extension
+    void setContext(const TransportContext& newContext) noexcept
+    {
+        context = newContext;
+        flags = static_cast<uint16_t>((flags & isPlayingFlag) | hasContextFlag
+                                      | (context.isLooping ? isLoopingFlag : 0)
+                                      | (context.isRecording ? isRecordingFlag : 0)
+                                      | (context.isDropFrame ? isDropFrameFlag : 0));
+    }
+
+    // `dest` must have room for getEncodedSize() bytes.
+    void encode(uint8_t* dest) const noexcept
+    {
+        dest[0] = 'T'; dest[1] = 'S'; dest[2] = 'B'; dest[3] = 'P';
+        dest[4] = currentVersion;
+        dest[5] = streamId;
+        store(dest + 6, flags);
+        store(dest + 8, sequence);
+        store(dest + 12, static_cast<uint64_t>(tickPosition));
+        store(dest + 20, bitsOf(tempo));
+        store(dest + 28, hostTimeNs);
+
+        if (!hasContext())
+            return;
+
+        dest[36] = static_cast<uint8_t>(std::clamp(context.timeSigNumerator, 1, 255));
+        dest[37] = static_cast<uint8_t>(std::clamp(context.timeSigDenominator, 1, 255));
+        dest[38] = dest[39] = 0;
+        store(dest + 40, static_cast<uint64_t>(ppqToTicks(context.loopStartPpq)));
+        store(dest + 48, static_cast<uint64_t>(ppqToTicks(context.loopEndPpq)));
+        store(dest + 56, static_cast<uint64_t>(ppqToTicks(context.barStartPpq)));
+        store(dest + 64, static_cast<uint32_t>(static_cast<int32_t>(std::clamp<int64_t>(context.barCount, -1, INT32_MAX))));
+        store(dest + 68, static_cast<uint32_t>(std::llround(std::max(0.0, context.frameRate) * 1000.0)));
+    }
+
+    // Returns false (leaving `packet` untouched) if this isn't a packet we understand.
+    static bool decode(const void* data, size_t numBytes, BinaryTransportPacket& packet) noexcept
+    {
+        const auto* src = static_cast<const uint8_t*>(data);
+
+        if (numBytes < size || !isBinaryTransportPacket(data, numBytes) || src[4] != currentVersion)
+            return false;
+
+        packet.streamId     = src[5];
+        packet.flags        = load<uint16_t>(src + 6);
+        packet.sequence     = load<uint32_t>(src + 8);
+        packet.tickPosition = static_cast<int64_t>(load<uint64_t>(src + 12));
+        packet.tempo        = doubleFromBits(load<uint64_t>(src + 20));
+        packet.hostTimeNs   = load<uint64_t>(src + 28);
+
+        // A truncated extension is treated as absent
+        if (packet.hasContext() && numBytes < sizeWithContext)
+            packet.flags = static_cast<uint16_t>(packet.flags & ~hasContextFlag);
+
+        if (packet.hasContext())
+        {
+            auto& c = packet.context;
+            c.timeSigNumerator   = src[36];
+            c.timeSigDenominator = src[37];
+            c.loopStartPpq       = ticksToPpq(static_cast<int64_t>(load<uint64_t>(src + 40)));
+            c.loopEndPpq         = ticksToPpq(static_cast<int64_t>(load<uint64_t>(src + 48)));
+            c.barStartPpq        = ticksToPpq(static_cast<int64_t>(load<uint64_t>(src + 56)));
+            c.barCount           = static_cast<int32_t>(load<uint32_t>(src + 64));
+            c.frameRate          = load<uint32_t>(src + 68) / 1000.0;
+            c.isLooping          = (packet.flags & isLoopingFlag) != 0;
+            c.isRecording        = (packet.flags & isRecordingFlag) != 0;
+            c.isDropFrame        = (packet.flags & isDropFrameFlag) != 0;
+        }
+
+        return true;
+    }
+
+    static bool isBinaryTransportPacket(const void* data, size_t numBytes) noexcept
+    {
+        const auto* src = static_cast<const uint8_t*>(data);
+        return numBytes >= 4 && src[0] == 'T' && src[1] == 'S' && src[2] == 'B' && src[3] == 'P';
+    }
+
+    // The stream ID alone, for routing before anything is decoded; 0 if there isn't one
+    static uint8_t peekStreamId(const void* data, size_t numBytes) noexcept
+    {
+        return numBytes >= size && isBinaryTransportPacket(data, numBytes) ? static_cast<const uint8_t*>(data)[5] : 0;
+    }
+
+    // True if `incoming` is newer than `last`, allowing for the sequence wrapping
+    static bool isNewerSequence(uint32_t incoming, uint32_t last) noexcept
+    {
+        return static_cast<int32_t>(incoming - last) > 0;
+    }
+
+private:
+    template <typename IntType>
+    static void store(uint8_t* dest, IntType value) noexcept
+    {
+        for (size_t i = 0; i < sizeof(IntType); ++i)
+            dest[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+
+    template <typename IntType>
+    static IntType load(const uint8_t* src) noexcept
+    {
+        IntType value = 0;
+
+        for (size_t i = 0; i < sizeof(IntType); ++i)
+            value = static_cast<IntType>(value | (static_cast<IntType>(src[i]) << (8 * i)));
+
+        return value;
+    }
+
+    static uint64_t bitsOf(double value) noexcept
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    static double doubleFromBits(uint64_t bits) noexcept
+    {
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+};
+
+/**
+ * @class BinarySequenceFilter
+ * @brief The receiving end of BinaryTransportPacket::sequence: drops packets
+ *        that arrive after a newer one, but starts over when the sender
+ *        evidently has. A sender that restarts (or a second one taking over
+ *        the port) begins again from 0, which looks like a jump far back;
+ *        after a long enough silence any sequence is accepted.
+ *
+ *        One thread only; reset() it from that thread too.
+ */
+class BinarySequenceFilter
+{
+public:
+    static constexpr int32_t maxReorderDistance = 256;              // Further back than this is a restart
+    static constexpr uint64_t resyncAfterSilenceNs = 2000000000;    // 2 s
+
+    bool accept(uint32_t sequence, uint64_t arrivalNs) noexcept
+    {
+        const auto distance = static_cast<int32_t>(sequence - lastSequence);
+        const bool isResync = !hasSequence || distance < -maxReorderDistance
+                              || arrivalNs - lastArrivalNs > resyncAfterSilenceNs;
+
+        if (!isResync && distance <= 0)
+            return false;
+
+        lastSequence = sequence;
+        lastArrivalNs = arrivalNs;
+        hasSequence = true;
+        return true;
+    }
+
+    void reset() noexcept   { hasSequence = false; }
+
+private:
+    uint32_t lastSequence = 0;
+    uint64_t lastArrivalNs = 0;
+    bool hasSequence = false;
+};
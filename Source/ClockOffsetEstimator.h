@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * @class ClockOffsetEstimator
+ * @brief Estimates the offset between our clock and a peer's, and the round
+ *        trip between us, from NTP-style ping/pong exchanges.
+ *
+ *        Each exchange gives four timestamps: t1 (ping sent, our clock), t2
+ *        (ping received, peer clock), t3 (pong sent, peer clock) and t4 (pong
+ *        received, our clock). Then
+ *
+ *            offset = ((t2 - t1) + (t3 - t4)) / 2     peer clock minus ours
+ *            rtt    = (t4 - t1) - (t3 - t2)           time spent on the network
+ *
+ *        Queueing delay only ever makes a sample worse, and asymmetrically so,
+ *        so like NTP's clock filter we keep the last few samples and trust the
+ *        one with the smallest round trip. Jitter is the RMS distance of the
+ *        other samples' offsets from that one.
+ */
+class ClockOffsetEstimator
+{
+public:
+    static constexpr int windowSize = 8;
+
+    struct Estimate
+    {
+        bool isValid = false;
+        int64_t offsetNs = 0;   // Add to our clock to get the peer's
+        uint64_t rttNs = 0;
+        uint64_t jitterNs = 0;
+        int numSamples = 0;
+    };
+
+    // Returns false for exchanges that can't be right (negative round trip, or
+    // a pong that took longer than `maxRttNs`), which are ignored.
+    bool addExchange(uint64_t t1, uint64_t t2, uint64_t t3, uint64_t t4) noexcept
+    {
+        const auto localElapsed = static_cast<int64_t>(t4 - t1);
+        const auto remoteElapsed = static_cast<int64_t>(t3 - t2);
+        const auto rtt = localElapsed - remoteElapsed;
+
+        if (localElapsed <= 0 || remoteElapsed < 0 || rtt < 0 || rtt > maxRttNs)
+            return false;
+
+        Sample& s = samples[static_cast<size_t>(next)];
+        s.offsetNs = (static_cast<int64_t>(t2 - t1) + static_cast<int64_t>(t3 - t4)) / 2;
+        s.rttNs = static_cast<uint64_t>(rtt);
+
+        next = (next + 1) % windowSize;
+        numSamples = numSamples < windowSize ? numSamples + 1 : windowSize;
+        updateEstimate();
+        return true;
+    }
+
+    const Estimate& getEstimate() const noexcept    { return estimate; }
+    bool isSynced() const noexcept                  { return estimate.isValid; }
+
+    // Our clock expressed in the peer's, or unchanged if we have no estimate yet
+    uint64_t toPeerTime(uint64_t localNs) const noexcept
+    {
+        return estimate.isValid ? localNs + static_cast<uint64_t>(estimate.offsetNs) : localNs;
+    }
+
+    void reset() noexcept
+    {
+        numSamples = 0;
+        next = 0;
+        estimate = {};
+    }
+
+    static constexpr int64_t maxRttNs = 1000000000; // 1 s; anything slower is a stale pong
+
+private:
+    struct Sample
+    {
+        int64_t offsetNs = 0;
+        uint64_t rttNs = 0;
+    };
+
+    void updateEstimate() noexcept
+    {
+        int best = 0;
+
+        for (int i = 1; i < numSamples; ++i)
+            if (samples[static_cast<size_t>(i)].rttNs < samples[static_cast<size_t>(best)].rttNs)
+                best = i;
+
+        const auto& chosen = samples[static_cast<size_t>(best)];
+        double sumSquares = 0.0;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto diff = static_cast<double>(samples[static_cast<size_t>(i)].offsetNs - chosen.offsetNs);
+            sumSquares += diff * diff;
+        }
+
+        estimate.isValid = true;
+        estimate.offsetNs = chosen.offsetNs;
+        estimate.rttNs = chosen.rttNs;
+        estimate.jitterNs = numSamples > 1 ? static_cast<uint64_t>(std::sqrt(sumSquares / (numSamples - 1))) : 0;
+        estimate.numSamples = numSamples;
+    }
+
+    std::array<Sample, windowSize> samples {};
+    int numSamples = 0;
+    int next = 0;
+    Estimate estimate;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <cstring>
+#include "OSCTransportEncoder.h"
+#include "TransportClock.h"
+
+/**
+ * @class ClockSyncResponder
+ * @brief Answers clock-sync pings from other TransportSenders, on its own
+ *        port so the OSC transport port never replies to anything.
+ *
+ *        A /ping carries only its token and t1. The /pong goes back to the
+ *        address and port the datagram came from, as a numeric IP, so the
+ *        responder never does a lookup and can't be pointed at a third party
+ *        by what a packet says.
+ *
+ *        t2 and t3 go out as NTP-epoch time, the same timescale as our bundle
+ *        timetags, so a peer's offset estimate maps its clock straight onto
+ *        ours on the wire.
+ */
+class ClockSyncResponder : public juce::Thread
+{
+public:
+    ClockSyncResponder() : juce::Thread("Clock Sync Responder") {}
+
+    ~ClockSyncResponder() override { stop(); }
+
+    bool start(int port)
+    {
+        if (!socket.bindToPort(port))
+        {
+            DBG("Error: clock sync responder couldn't bind port " + juce::String(port) + ".");
+            return false;
+        }
+
+        startThread();
+        return true;
+    }
+
+    void stop()
+    {
+        signalThreadShouldExit();
+        stopThread(2 * pollTimeoutMs);
+    }
+
+    void run() override
+    {
+        char buffer[pingSize + 1];
+        juce::String senderIP;
+        int senderPort = 0;
+
+        while (!threadShouldExit())
+        {
+            const auto ready = socket.waitUntilReady(true, pollTimeoutMs);
+
+            if (ready < 0)
+                break;
+
+            if (ready == 0)
+                continue;
+
+            const auto size = socket.read(buffer, (int) sizeof(buffer), false, senderIP, senderPort);
+            const auto arrivalNs = TransportClock::nowNs();
+
+            if (size == pingSize)
+                answerPing(buffer, arrivalNs, senderIP, senderPort);
+        }
+    }
+
+private:
+    // "/ping" ",iii" token t1hi t1lo, exactly as OSCTransportEncoder::encodePing() writes it
+    static constexpr int pingSize = 28;
+    static constexpr int pollTimeoutMs = 100;
+
+    void answerPing(const char* data, uint64_t arrivalNs, const juce::String& senderIP, int senderPort)
+    {
+        static constexpr char header[] = "/ping\0\0\0,iii\0\0\0";
+
+        if (std::memcmp(data, header, 16) != 0 || senderPort <= 0)
+            return;
+
+        const auto readInt = [data](int offset) { return (int32_t) juce::ByteOrder::bigEndianInt(data + offset); };
+
+        const auto epochOffset = TransportClock::ntpEpochOffsetNs();
+        const auto t1 = TransportClock::fromWords(readInt(20), readInt(24));
+        const auto& pong = encoder.encodePong(readInt(16), t1, arrivalNs + epochOffset, TransportClock::nowNs() + epochOffset);
+
+        if (!pong.hasOverflowed())
+            socket.write(senderIP, senderPort, pong.getData(), (int) pong.getSize());
+    }
+
+    // This thread only
+    juce::DatagramSocket socket { false };
+    OSCTransportEncoder encoder;
+
+    JUCE_DECLARE_NON_COPYABLE(ClockSyncResponder)
+};
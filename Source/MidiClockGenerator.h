@@ -0,0 +1,132 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <cmath>
+#include <limits>
+
+/**
+ * @class MidiClockGenerator
+ * @brief Turns the host transport into MIDI beat clock: 24 timing clocks per
+ *        quarter note at exact sample offsets, plus Start, Stop, Continue and
+ *        Song Position Pointer on transport changes and jumps.
+ *
+ *        Every tick is placed where the host's ppq crosses a multiple of 1/24,
+ *        working forward from each block's host position rather than counting
+ *        samples, so rounding never accumulates and the same tick lands on the
+ *        same absolute sample whatever the block size. Hosts report one tempo
+ *        per block, so the tempo is taken as constant within a block.
+ *
+ *        Small disagreements between where a block starts and where the last
+ *        one predicted (a tempo change the host applied mid-block) are absorbed
+ *        without dropping or doubling ticks. Anything bigger than a tick is a
+ *        locate or loop: receivers get Stop, the SPP of the next 16th and
+ *        Continue, and clocks resume from that 16th.
+ *
+ *        Audio thread only. process() only appends to the MidiBuffer it is
+ *        given, so it allocates nothing as long as that buffer was reserved
+ *        with getMaxBytesPerBlock() bytes for the longest block it is given.
+ */
+class MidiClockGenerator
+{
+public:
+    static constexpr int ticksPerQuarterNote = 24;
+    static constexpr double maxReservedBpm = 999.0; // Faster than this, a block's events may outgrow the reservation
+
+    struct Block
+    {
+        bool isPlaying = false;
+        double ppqAtStart = 0.0;
+        double bpm = 120.0;
+        int numSamples = 0;
+    };
+
+    void prepare(double newSampleRate) noexcept
+    {
+        sampleRate = newSampleRate;
+        reset();
+    }
+
+    // The most one process() call can add to a MidiBuffer: every tick of a
+    // block at maxReservedBpm, one the last block missed, and Stop, SPP and
+    // Continue. For MidiBuffer::ensureSize() in prepareToPlay.
+    static size_t getMaxBytesPerBlock(int maxBlockSize, double sampleRate) noexcept
+    {
+        const double maxTicks = std::ceil(std::max(maxBlockSize, 1) * maxReservedBpm / (60.0 * std::max(sampleRate, 1.0))
+                                          * ticksPerQuarterNote) + 1.0;
+        return static_cast<size_t>(maxTicks + 3.0) * bytesPerEvent;
+    }
+
+    // Forget the running state; the next playing block sends Start or Continue again
+    void reset() noexcept
+    {
+        running = false;
+        hasExpectation = false;
+        nextTick = 0;
+    }
+
+    void process(const Block& block, juce::MidiBuffer& midi)
+    {
+        if (block.numSamples <= 0 || sampleRate <= 0.0)
+            return;
+
+        if (!block.isPlaying)
+        {
+            if (running)
+                midi.addEvent(juce::MidiMessage::midiStop(), 0);
+
+            running = false;
+            hasExpectation = false;
+            return;
+        }
+
+        const double beatsPerSample = std::max(block.bpm, 1.0) / (60.0 * sampleRate);
+
+        const bool jumped = hasExpectation && std::abs(block.ppqAtStart - expectedPpq) >= 1.0 / ticksPerQuarterNote;
+
+        if (!running || jumped)
+        {
+            if (running)
+                midi.addEvent(juce::MidiMessage::midiStop(), 0);
+
+            // Clocks resume from the next 16th, which is all SPP can express
+            const auto sixteenth = static_cast<int>(std::ceil(std::max(0.0, block.ppqAtStart) * 4.0 - 1.0e-9));
+            midi.addEvent(juce::MidiMessage::songPositionPointer(sixteenth), 0);
+            midi.addEvent(sixteenth == 0 ? juce::MidiMessage::midiStart() : juce::MidiMessage::midiContinue(), 0);
+
+            nextTick = static_cast<int64_t>(sixteenth) * (ticksPerQuarterNote / 4);
+            running = true;
+        }
+
+        // Ticks the last block's prediction missed go out at the start of this one
+        for (;; ++nextTick)
+        {
+            const double beatsAhead = static_cast<double>(nextTick) / ticksPerQuarterNote - block.ppqAtStart;
+            const int offset = beatsAhead <= 0.0 ? 0 : sampleOffsetFor(beatsAhead, beatsPerSample);
+
+            if (offset >= block.numSamples)
+                break;
+
+            midi.addEvent(juce::MidiMessage::midiClock(), offset);
+        }
+
+        expectedPpq = block.ppqAtStart + block.numSamples * beatsPerSample;
+        hasExpectation = true;
+    }
+
+private:
+    static constexpr size_t bytesPerEvent = 9; // MidiBuffer's sample position and size fields, and up to 3 data bytes
+
+    // First sample at or after the point `beats` into the block
+    static int sampleOffsetFor(double beats, double beatsPerSample) noexcept
+    {
+        const double rounded = std::ceil(beats / beatsPerSample - 1.0e-6);
+        return rounded >= static_cast<double>(std::numeric_limits<int>::max()) ? std::numeric_limits<int>::max()
+                                                                                 : static_cast<int>(rounded);
+    }
+
+    double sampleRate = 44100.0;
+    bool running = false;
+    bool hasExpectation = false;
+    double expectedPpq = 0.0;
+    int64_t nextTick = 0;
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "TransportStream.h"
+
+/**
+ * @class OSCConnectionManager
+ * @brief The background thread that looks up every stream's destinations.
+ *        Setting destinations, preparing to play and sending all return
+ *        straight away; lookups happen here, one at a time and with no lock
+ *        held, so a slow DNS server delays nothing but the link it is for.
+ *
+ *        It wakes when destinations change (notifyDestinationsChanged()),
+ *        when a failed lookup is due again, and every half second to check
+ *        on links whose sends have started failing. See
+ *        OSCDestinationSet::beginLookup() for the states and backoff.
+ */
+class OSCConnectionManager : public juce::Thread
+{
+public:
+    OSCConnectionManager() : juce::Thread("OSC Connection Manager") {}
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            int waitMs = maxWaitMs;
+
+            for (int i = 0; !threadShouldExit(); ++i)
+            {
+                TransportStream* stream = nullptr;
+                OSCDestinationSet::Lookup lookup;
+                int msUntilDue = maxWaitMs;
+
+                {
+                    const juce::ScopedLock sl(streamsLock);
+
+                    if (i >= streams.size())
+                        break;
+
+                    stream = streams.getUnchecked(i);
+
+                    if (!stream->beginLookup(lookup, msUntilDue))
+                    {
+                        waitMs = juce::jmin(waitMs, msUntilDue);
+                        continue;
+                    }
+                }
+
+                OSCDestinationSet::performLookup(lookup);
+
+                {
+                    // The stream may have gone, or changed its list, while we waited on DNS
+                    const juce::ScopedLock sl(streamsLock);
+
+                    if (streams.contains(stream))
+                        stream->completeLookup(lookup);
+                }
+
+                --i; // Same stream again, for its next due destination
+            }
+
+            wait(juce::jmax(1, waitMs));
+        }
+    }
+
+    // Once removeStream() returns, the thread will not touch that stream again.
+    // Neither waits for a lookup in progress.
+    void addStream(TransportStream& stream)
+    {
+        {
+            const juce::ScopedLock sl(streamsLock);
+            streams.addIfNotAlreadyThere(&stream);
+        }
+
+        notify();
+    }
+
+    void removeStream(TransportStream& stream)
+    {
+        const juce::ScopedLock sl(streamsLock);
+        streams.removeFirstMatchingValue(&stream);
+    }
+
+    // Call after setting a stream's destinations, to look them up straight away
+    void notifyDestinationsChanged() { notify(); }
+
+private:
+    static constexpr int maxWaitMs = 1000;
+
+    juce::CriticalSection streamsLock; // Never held across a lookup
+    juce::Array<TransportStream*> streams;
+};
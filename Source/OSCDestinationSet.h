@@ -0,0 +1,669 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <cstring>
+#include "ClockOffsetEstimator.h"
+#include "OSCTransportEncoder.h"
+#include "TransportClock.h"
+
+#if JUCE_WINDOWS
+ #include <winsock2.h>
+ #include <ws2tcpip.h>
+#else
+ #include <arpa/inet.h>
+ #include <cerrno>
+ #include <fcntl.h>
+ #include <netdb.h>
+ #include <netinet/in.h>
+ #include <sys/socket.h>
+#endif
+
+// A "host:port" pair the transport stream is sent to. "host:port sync" also
+// keeps a clock offset to it, for a peer that is another TransportSender.
+struct OSCDestination
+{
+    juce::String host;
+    int port = 0;
+    bool syncClock = false; // Ping it, and send it timetags in its own clock
+
+    juce::String toString() const { return host + ":" + juce::String(port) + (syncClock ? " sync" : ""); }
+
+    static OSCDestination fromString(const juce::String& text)
+    {
+        OSCDestination d;
+        auto hostPort = text.trim();
+
+        if (hostPort.endsWithIgnoreCase(" sync"))
+        {
+            d.syncClock = true;
+            hostPort = hostPort.dropLastCharacters(5).trim();
+        }
+
+        d.host = hostPort.upToLastOccurrenceOf(":", false, false).trim();
+        d.port = hostPort.fromLastOccurrenceOf(":", false, false).getIntValue();
+        return d;
+    }
+
+    bool isValid() const { return host.isNotEmpty() && port > 0 && port < 65536; }
+
+    // 224.0.0.0/4: one send reaches every receiver that has joined the group
+    bool isMulticast() const
+    {
+        const int firstOctet = host.upToFirstOccurrenceOf(".", false, false).getIntValue();
+        return host.containsOnly("0123456789.") && firstOctet >= 224 && firstOctet <= 239;
+    }
+};
+
+// How multicast packets leave the send socket. These are socket options, so
+// they apply to every stream sharing it.
+struct MulticastOptions
+{
+    int ttl = 1;                    // Router hops; 1 keeps packets on the local segment
+    juce::String interfaceAddress;  // IPv4 address of the interface to send from; empty for the OS's choice
+    bool loopback = true;           // Also deliver to group members on this machine
+
+    bool operator==(const MulticastOptions& other) const
+    {
+        return ttl == other.ttl && interfaceAddress == other.interfaceAddress && loopback == other.loopback;
+    }
+};
+
+/**
+ * @class OSCDestinationSet
+ * @brief The list of places each encoded transport packet is sent to.
+ *
+ *        Addresses are looked up by the OSCConnectionManager thread, never by
+ *        the sender or the caller of setDestinations(), so neither ever waits
+ *        on DNS; the sender only ever sends to the numeric address the lookup
+ *        found. A destination whose lookup fails, or whose sends keep failing,
+ *        is looked up again with exponential backoff. A packet is encoded once
+ *        and handed to every healthy destination in one batch (sendmmsg on
+ *        Linux, one sendto per target elsewhere) on a non-blocking socket. Each
+ *        destination tracks its own failures and backs off exponentially, so a
+ *        dead or slow target is skipped instead of holding up the others.
+ *
+ *        The multicast socket options (setMulticastOptions(), joining a group)
+ *        are POSIX only; on Windows they return false, and a group destination
+ *        gets the OS's default TTL and interface.
+ *
+ *        Destinations marked syncClock are pinged, and once they answer, bundle
+ *        timetags sent to them are moved into their clock domain. The rewrite
+ *        touches only the 8 timetag bytes, so the packet is still encoded once.
+ *        Anything else (Max, Ableton, a lighting desk) is never pinged.
+ *
+ *        A multicast group is a single destination however many receivers
+ *        have joined it. It is never pinged (every member would answer the one
+ *        token), so its timetags stay in our clock.
+ */
+class OSCDestinationSet
+{
+public:
+    static constexpr int maxDestinations = 32;
+
+    enum class LinkState
+    {
+        idle,       // No destinations
+        resolving,  // First lookup not finished yet
+        connected,  // Resolved, and the last send went through
+        degraded,   // Some destinations connected, others not (whole set only)
+        down        // Lookup or sends failing; retrying with backoff
+    };
+
+    struct Stats
+    {
+        juce::String name;
+        LinkState state = LinkState::resolving;
+        juce::uint64 packetsSent = 0;
+        juce::uint64 bytesSent = 0;
+        juce::uint64 sendFailures = 0;
+        bool isHealthy = true;
+        bool isMulticast = false;
+
+        // Clock sync; only meaningful once the destination has answered a /ping
+        bool clockSynced = false;
+        double clockOffsetMs = 0.0; // Their wall clock minus ours
+        double roundTripMs = 0.0;
+        double jitterMs = 0.0;
+    };
+
+    // Call from any non-realtime thread; returns at once; the lookups happen on
+    // the connection manager's thread. Returns false if any entry was dropped.
+    bool setDestinations(const juce::Array<OSCDestination>& newDestinations)
+    {
+        juce::OwnedArray<Target> newTargets;
+        bool allAccepted = true;
+
+        for (auto& d : newDestinations)
+        {
+            if (newTargets.size() >= maxDestinations || !d.isValid())
+            {
+                DBG("Ignoring OSC destination " + d.toString());
+                allAccepted = false;
+                continue;
+            }
+
+            newTargets.add(new Target())->destination = d;
+        }
+
+        const juce::ScopedLock sl(lock);
+        targets.swapWith(newTargets);
+        generation = nextGeneration++;
+        return allAccepted;
+    }
+
+    //==============================================================================
+    // Lookups, connection manager thread only. beginLookup() and completeLookup()
+    // are quick and take the lock; performLookup() does the DNS without it, so
+    // sending carries on meanwhile.
+
+    struct Lookup
+    {
+        OSCDestination destination;
+        int index = -1;
+        juce::uint32 generation = 0; // Unique per list, so a result never lands in a list set since
+        bool succeeded = false;
+        sockaddr_storage address {};
+        socklen_t addressLength = 0;
+    };
+
+    // Picks a destination that is due a lookup: new, failed last time, or
+    // resolved but failing every send. Otherwise returns false and sets
+    // msUntilDue to when one next could be.
+    bool beginLookup(Lookup& lookup, int& msUntilDue) const
+    {
+        const juce::ScopedLock sl(lock);
+        const auto now = juce::Time::getMillisecondCounter();
+        msUntilDue = healthCheckIntervalMs;
+
+        for (int i = 0; i < targets.size(); ++i)
+        {
+            auto* t = targets.getUnchecked(i);
+
+            if (t->resolved && t->consecutiveFailures < unhealthyAfterFailures)
+                continue;
+
+            const auto wait = (juce::int32) (t->nextLookupMs - now);
+
+            if (wait > 0)
+            {
+                msUntilDue = juce::jmin(msUntilDue, (int) wait);
+                continue;
+            }
+
+            lookup.destination = t->destination;
+            lookup.index = i;
+            lookup.generation = generation;
+            return true;
+        }
+
+        return false;
+    }
+
+    static void performLookup(Lookup& lookup)
+    {
+        lookup.succeeded = resolve(lookup);
+    }
+
+    void completeLookup(const Lookup& lookup)
+    {
+        const juce::ScopedLock sl(lock);
+        auto* t = targets[lookup.index];
+
+        if (t == nullptr || lookup.generation != generation)
+            return;
+
+        if (lookup.succeeded)
+        {
+            t->address = lookup.address;
+            t->addressLength = lookup.addressLength;
+            t->resolved = true;
+        }
+        else if (!t->resolved && t->lookupAttempts == 0)
+        {
+            DBG("Could not resolve OSC destination " + t->destination.toString());
+        }
+
+        // A failing link gets looked up again, less often each time it doesn't help
+        const bool healthy = t->resolved && t->consecutiveFailures < unhealthyAfterFailures;
+        t->lookupAttempts = healthy ? 0 : t->lookupAttempts + 1;
+        t->nextLookupMs = juce::Time::getMillisecondCounter()
+                        + (healthy ? 0 : juce::jmin(maxLookupBackoffMs, minLookupBackoffMs << juce::jmin(t->lookupAttempts - 1, 8)));
+    }
+
+    struct LinkSummary
+    {
+        LinkState state = LinkState::idle;
+        int numConnected = 0;
+        int numDestinations = 0;
+    };
+
+    // The whole set at a glance, for the editor. No allocation, so it can be polled every frame.
+    LinkSummary getLinkSummary() const
+    {
+        const juce::ScopedLock sl(lock);
+        LinkSummary summary;
+        summary.numDestinations = targets.size();
+
+        if (targets.isEmpty())
+            return summary;
+
+        int numResolving = 0;
+
+        for (auto* t : targets)
+        {
+            const auto state = getState(*t);
+            summary.numConnected += state == LinkState::connected ? 1 : 0;
+            numResolving += state == LinkState::resolving ? 1 : 0;
+        }
+
+        if (summary.numConnected == targets.size())     summary.state = LinkState::connected;
+        else if (summary.numConnected > 0)              summary.state = LinkState::degraded;
+        else if (numResolving > 0)                      summary.state = LinkState::resolving;
+        else                                            summary.state = LinkState::down;
+
+        return summary;
+    }
+
+    LinkState getLinkState() const { return getLinkSummary().state; }
+
+    juce::Array<OSCDestination> getDestinations() const
+    {
+        juce::Array<OSCDestination> result;
+        const juce::ScopedLock sl(lock);
+
+        for (auto* t : targets)
+            result.add(t->destination);
+
+        return result;
+    }
+
+    // Sender thread only. Returns the number of destinations that accepted the packet.
+    // For an OSC bundle, pass isTimeTaggedBundle so synced destinations get the
+    // timetag in their own clock.
+    int sendToAll(juce::DatagramSocket& socket, const char* data, size_t size, bool isTimeTaggedBundle = false)
+    {
+        const juce::ScopedLock sl(lock);
+        const auto now = juce::Time::getMillisecondCounter();
+
+        Target* batch[maxDestinations];
+        int numInBatch = 0;
+
+        for (auto* t : targets)
+            if (t->resolved && (t->consecutiveFailures == 0 || (juce::int32) (now - t->retryTimeMs) >= 0))
+                batch[numInBatch++] = t;
+
+        if (numInBatch == 0)
+            return 0;
+
+        const bool patchTimeTags = isTimeTaggedBundle && size >= timeTagEnd;
+        const auto timeTag = patchTimeTags ? loadBigEndian64(data + timeTagStart) : 0;
+
+       #if JUCE_LINUX
+        mmsghdr messages[maxDestinations];
+        iovec payloads[maxDestinations][3];
+
+        for (int i = 0; i < numInBatch; ++i)
+        {
+            auto* iov = payloads[i];
+
+            messages[i] = {};
+            messages[i].msg_hdr.msg_name = &batch[i]->address;
+            messages[i].msg_hdr.msg_namelen = batch[i]->addressLength;
+            messages[i].msg_hdr.msg_iov = iov;
+
+            // Synced targets get the shared bytes either side of their own timetag
+            if (patchTimeTags && batch[i]->clock.isSynced())
+            {
+                storeBigEndian64(batch[i]->peerTimeTag, toPeerTimeTag(timeTag, batch[i]->clock));
+                iov[0] = { const_cast<char*>(data), timeTagStart };
+                iov[1] = { batch[i]->peerTimeTag, timeTagEnd - timeTagStart };
+                iov[2] = { const_cast<char*>(data + timeTagEnd), size - timeTagEnd };
+                messages[i].msg_hdr.msg_iovlen = 3;
+            }
+            else
+            {
+                iov[0] = { const_cast<char*>(data), size };
+                messages[i].msg_hdr.msg_iovlen = 1;
+            }
+        }
+
+        // sendmmsg stops at the first target that fails; record it and carry on after it
+        int numSent = 0;
+
+        for (int start = 0; start < numInBatch;)
+        {
+            const int result = ::sendmmsg(socket.getRawSocketHandle(), messages + start, (unsigned int) (numInBatch - start), 0);
+
+            if (result < 0 && errno == EINTR)
+                continue;
+
+            const int numOk = juce::jmax(0, result);
+
+            for (int i = start; i < start + numOk; ++i)
+                recordResult(*batch[i], messages[i].msg_len == size, size, now);
+
+            numSent += numOk;
+            start += numOk;
+
+            if (start < numInBatch)
+                recordResult(*batch[start++], false, size, now);
+        }
+
+        return numSent;
+       #else
+        int numSent = 0;
+        char patched[OSCPacketWriter::maxPacketSize];
+        bool hasPatchedCopy = false;
+
+        for (int i = 0; i < numInBatch; ++i)
+        {
+            const char* packet = data;
+
+            if (patchTimeTags && batch[i]->clock.isSynced() && size <= sizeof(patched))
+            {
+                if (!hasPatchedCopy)
+                    std::memcpy(patched, data, size);
+
+                hasPatchedCopy = true;
+                char peerTimeTag[8];
+                storeBigEndian64(peerTimeTag, toPeerTimeTag(timeTag, batch[i]->clock));
+                std::memcpy(patched + timeTagStart, peerTimeTag, sizeof(peerTimeTag));
+                packet = patched;
+            }
+
+            const bool ok = sendOne(socket, *batch[i], packet, size);
+            recordResult(*batch[i], ok, size, now);
+            numSent += ok ? 1 : 0;
+        }
+
+        return numSent;
+       #endif
+    }
+
+    juce::Array<Stats> getStats() const
+    {
+        juce::Array<Stats> result;
+        const juce::ScopedLock sl(lock);
+
+        for (auto* t : targets)
+        {
+            Stats s;
+            s.name = t->destination.toString();
+            s.packetsSent = t->packetsSent.load(std::memory_order_relaxed);
+            s.bytesSent = t->bytesSent.load(std::memory_order_relaxed);
+            s.sendFailures = t->sendFailures.load(std::memory_order_relaxed);
+            s.state = getState(*t);
+            s.isHealthy = s.state == LinkState::connected;
+            s.isMulticast = t->destination.isMulticast();
+
+            const auto& estimate = t->clock.getEstimate();
+            s.clockSynced = estimate.isValid;
+            // The estimate maps our nowNs() onto the peer's NTP time; take our own epoch back off
+            s.clockOffsetMs = estimate.isValid ? (double) (estimate.offsetNs - (int64_t) TransportClock::ntpEpochOffsetNs()) / 1.0e6
+                                               : 0.0;
+            s.roundTripMs = estimate.rttNs / 1.0e6;
+            s.jitterMs = estimate.jitterNs / 1.0e6;
+            result.add(s);
+        }
+
+        return result;
+    }
+
+    // Sends each reachable syncClock destination a /ping, to its host's
+    // clockSyncPort. The peer answers to wherever the ping came from, so send
+    // it from the socket our /pongs are read on. The token carries the stream
+    // ID, the list's generation and the destination's index, so a /pong finds
+    // its way back here and one for a list since replaced is ignored.
+    // Sender thread only.
+    void sendPings(juce::DatagramSocket& socket, OSCTransportEncoder& encoder, int streamId, int clockSyncPort)
+    {
+        const juce::ScopedLock sl(lock);
+        const auto now = juce::Time::getMillisecondCounter();
+
+        for (int i = 0; i < targets.size(); ++i)
+        {
+            auto* t = targets.getUnchecked(i);
+
+            if (!t->destination.syncClock || !t->resolved || t->destination.isMulticast()
+                || (t->consecutiveFailures > 0 && (juce::int32) (now - t->retryTimeMs) < 0))
+                continue;
+
+            const auto& ping = encoder.encodePing(makePingToken(streamId, generation, i), TransportClock::nowNs());
+
+            if (!ping.hasOverflowed())
+                sendPing(socket, *t, clockSyncPort, ping.getData(), ping.getSize());
+        }
+    }
+
+    // Receiver thread. t1 and t4 are our clock, t2 and t3 the destination's.
+    void pongReceived(int32_t token, uint64_t t1, uint64_t t2, uint64_t t3, uint64_t t4)
+    {
+        const juce::ScopedLock sl(lock);
+
+        if (getGenerationFromToken(token) != (generation & generationMask))
+            return; // Answers a ping to a list that has been replaced since
+
+        if (auto* t = targets[getDestinationIndexFromToken(token)])
+            t->clock.addExchange(t1, t2, t3, t4);
+    }
+
+    // stream ID (8 bits) | list generation (low 16 bits) | destination index (8 bits)
+    static int32_t makePingToken(int streamId, juce::uint32 listGeneration, int destinationIndex)
+    {
+        return (int32_t) (((juce::uint32) (streamId & 0xff) << 24) | ((listGeneration & generationMask) << 8)
+                          | (juce::uint32) (destinationIndex & 0xff));
+    }
+
+    static int getStreamIdFromToken(int32_t token) { return (int) ((juce::uint32) token >> 24); }
+    static juce::uint32 getGenerationFromToken(int32_t token) { return ((juce::uint32) token >> 8) & generationMask; }
+    static int getDestinationIndexFromToken(int32_t token) { return (int) (token & 0xff); }
+
+    int size() const
+    {
+        const juce::ScopedLock sl(lock);
+        return targets.size();
+    }
+
+    // A full send buffer must fail the send rather than stall every other destination
+    static void makeNonBlocking(juce::DatagramSocket& socket)
+    {
+        const int fd = socket.getRawSocketHandle();
+
+       #if JUCE_WINDOWS
+        u_long nonBlocking = 1;
+
+        if (fd >= 0)
+            ioctlsocket((SOCKET) fd, FIONBIO, &nonBlocking);
+       #else
+        const int flags = fcntl(fd, F_GETFL, 0);
+
+        if (fd >= 0 && flags >= 0 && (flags & O_NONBLOCK) == 0)
+            fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+       #endif
+    }
+
+    // TTL, interface and loopback for multicast sends from `socket`. Returns false
+    // if the interface isn't an IPv4 address or the OS refuses an option.
+    static bool applyMulticastOptions(juce::DatagramSocket& socket, const MulticastOptions& options)
+    {
+       #if ! JUCE_WINDOWS
+        const int fd = socket.getRawSocketHandle();
+        const auto ttl = (unsigned char) juce::jlimit(0, 255, options.ttl); // u_char is what every platform accepts
+        const unsigned char loopback = options.loopback ? 1 : 0;
+        in_addr interfaceAddress {};
+        interfaceAddress.s_addr = htonl(INADDR_ANY);
+
+        if (fd < 0 || (options.interfaceAddress.isNotEmpty() && inet_pton(AF_INET, options.interfaceAddress.toRawUTF8(), &interfaceAddress) != 1))
+            return false;
+
+        return setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) == 0
+            && setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loopback, sizeof(loopback)) == 0
+            && setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &interfaceAddress, sizeof(interfaceAddress)) == 0;
+       #else
+        juce::ignoreUnused(socket, options);
+        return false;
+       #endif
+    }
+
+    // Joins or leaves `group` on a bound receive socket, on the given interface
+    // (empty for the OS's choice). DatagramSocket::joinMulticast() can't pick one.
+    static bool setMulticastMembership(juce::DatagramSocket& socket, const juce::String& group,
+                                       const juce::String& interfaceAddress, bool shouldJoin)
+    {
+       #if ! JUCE_WINDOWS
+        const int fd = socket.getRawSocketHandle();
+        ip_mreq request {};
+        request.imr_interface.s_addr = htonl(INADDR_ANY);
+
+        if (fd < 0 || inet_pton(AF_INET, group.toRawUTF8(), &request.imr_multiaddr) != 1
+            || !OSCDestination { group, 1 }.isMulticast()
+            || (interfaceAddress.isNotEmpty() && inet_pton(AF_INET, interfaceAddress.toRawUTF8(), &request.imr_interface) != 1))
+            return false;
+
+        return setsockopt(fd, IPPROTO_IP, shouldJoin ? IP_ADD_MEMBERSHIP : IP_DROP_MEMBERSHIP, &request, sizeof(request)) == 0;
+       #else
+        juce::ignoreUnused(socket, group, interfaceAddress, shouldJoin);
+        return false;
+       #endif
+    }
+
+private:
+    struct Target
+    {
+        OSCDestination destination;
+        bool resolved = false;
+        sockaddr_storage address {};
+        socklen_t addressLength = 0;
+
+        // Health, touched only by the sender thread
+        int consecutiveFailures = 0;
+        juce::uint32 retryTimeMs = 0;
+
+        // Lookups, touched only by the connection manager
+        int lookupAttempts = 0;
+        juce::uint32 nextLookupMs = 0;
+
+        std::atomic<juce::uint64> packetsSent { 0 };
+        std::atomic<juce::uint64> bytesSent { 0 };
+        std::atomic<juce::uint64> sendFailures { 0 };
+
+        // Clock sync, under the lock: fed by the receiver thread, read by the sender
+        ClockOffsetEstimator clock;
+        char peerTimeTag[8] {};
+    };
+
+    // Position of the timetag in an OSC bundle, straight after "#bundle\0"
+    static constexpr size_t timeTagStart = 8;
+    static constexpr size_t timeTagEnd = 16;
+
+    static constexpr juce::uint32 minBackoffMs = 50;
+    static constexpr juce::uint32 maxBackoffMs = 5000;
+
+    // A resolved destination counts as down, and is looked up again, after this
+    // many sends in a row fail (about 1.5 s of the send backoff)
+    static constexpr int unhealthyAfterFailures = 5;
+    static constexpr int healthCheckIntervalMs = 500;
+    static constexpr juce::uint32 minLookupBackoffMs = 250;
+    static constexpr juce::uint32 maxLookupBackoffMs = 30000;
+    static constexpr juce::uint32 generationMask = 0xffff;
+
+    static LinkState getState(const Target& t)
+    {
+        if (!t.resolved)
+            return t.lookupAttempts == 0 ? LinkState::resolving : LinkState::down;
+
+        return t.consecutiveFailures == 0 ? LinkState::connected : LinkState::down;
+    }
+
+    // Connection manager thread. JUCE has already started Winsock on Windows, as
+    // the engine's sockets exist before any lookup.
+    static bool resolve(Lookup& lookup)
+    {
+        addrinfo hints {};
+        hints.ai_family = AF_INET; // juce::DatagramSocket is IPv4
+        hints.ai_socktype = SOCK_DGRAM;
+
+        addrinfo* info = nullptr;
+
+        if (getaddrinfo(lookup.destination.host.toRawUTF8(), juce::String(lookup.destination.port).toRawUTF8(), &hints, &info) != 0 || info == nullptr)
+            return false;
+
+        std::memcpy(&lookup.address, info->ai_addr, (size_t) info->ai_addrlen);
+        lookup.addressLength = (socklen_t) info->ai_addrlen;
+        freeaddrinfo(info);
+        return true;
+    }
+
+    // The peer stamps its pongs with NTP-epoch time (see ClockSyncResponder),
+    // so the estimate already includes the peer's epoch offset
+    static uint64_t toPeerTimeTag(uint64_t timeTag, const ClockOffsetEstimator& clock)
+    {
+        return TransportClock::nsToFixedPoint(clock.toPeerTime(TransportClock::timeTagToNs(timeTag)));
+    }
+
+    static uint64_t loadBigEndian64(const char* src)
+    {
+        uint64_t value = 0;
+
+        for (int i = 0; i < 8; ++i)
+            value = (value << 8) | (uint8_t) src[i];
+
+        return value;
+    }
+
+    static void storeBigEndian64(char* dest, uint64_t value)
+    {
+        for (int i = 7; i >= 0; --i, value >>= 8)
+            dest[i] = (char) (value & 0xff);
+    }
+
+    // Straight to the looked-up address: DatagramSocket::write() would resolve the host name again
+    static bool sendTo(juce::DatagramSocket& socket, const sockaddr_storage& address, socklen_t addressLength, const char* data, size_t size)
+    {
+       #if JUCE_WINDOWS
+        return ::sendto((SOCKET) socket.getRawSocketHandle(), data, (int) size, 0, (const sockaddr*) &address, addressLength) == (int) size;
+       #else
+        return ::sendto(socket.getRawSocketHandle(), data, size, 0, (const sockaddr*) &address, addressLength) == (ssize_t) size;
+       #endif
+    }
+
+    static bool sendOne(juce::DatagramSocket& socket, Target& t, const char* data, size_t size)
+    {
+        return sendTo(socket, t.address, t.addressLength, data, size);
+    }
+
+    // To the destination's host, but the peer's clock-sync port rather than its OSC port
+    static bool sendPing(juce::DatagramSocket& socket, Target& t, int clockSyncPort, const char* data, size_t size)
+    {
+        auto address = t.address;
+
+        if (address.ss_family != AF_INET)
+            return false;
+
+        reinterpret_cast<sockaddr_in&>(address).sin_port = htons((uint16_t) clockSyncPort);
+        return sendTo(socket, address, t.addressLength, data, size);
+    }
+
+    static void recordResult(Target& t, bool ok, size_t size, juce::uint32 now)
+    {
+        if (ok)
+        {
+            t.consecutiveFailures = 0;
+            t.packetsSent.fetch_add(1, std::memory_order_relaxed);
+            t.bytesSent.fetch_add(size, std::memory_order_relaxed);
+            return;
+        }
+
+        t.sendFailures.fetch_add(1, std::memory_order_relaxed);
+        const auto backoff = juce::jmin(maxBackoffMs, minBackoffMs << juce::jmin(t.consecutiveFailures, 7));
+        t.retryTimeMs = now + backoff;
+        ++t.consecutiveFailures;
+    }
+
+    juce::CriticalSection lock; // Sender thread vs. configuration changes and lookups; never the audio thread
+    juce::OwnedArray<Target> targets;
+    juce::uint32 generation = 0;
+
+    static inline std::atomic<juce::uint32> nextGeneration { 1 };
+};
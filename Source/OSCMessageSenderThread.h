@@ -1,71 +1,150 @@
 #pragma once
 
-#include <queue>
 #include <JuceHeader.h>
-
-// Define the OSCTransportMessage struct here since it doesn't exist in a separate file.
-struct OSCTransportMessage
-{
-    bool isPlaying;
-    float tempo;
-    float position;
-};
+#include "RealtimeSignal.h"
+#include "OSCDestinationSet.h"
+#include "TransportStream.h"
 
 /**
  * @class OSCMessageSenderThread
- * @brief A background thread that continuously checks a queue for transport data
- *        and sends corresponding OSC messages.
+ * @brief A background thread that sends every registered stream's queued
+ *        transport events and latest published update. It sleeps until some
+ *        processBlock calls notifyWorkAvailable(), so an idle transport costs
+ *        no wakeups, and a slow network never builds a backlog of stale positions.
+ *
+ *        One thread and one UDP socket serve all streams in the process.
+ *        Packets are built by each stream's OSCTransportEncoder into a reused
+ *        buffer once per update and fanned out to that stream's destinations,
+ *        so sending does no heap allocation however many targets there are.
+ *
+ *        Every pingIntervalMs it also pings the destinations marked for clock
+ *        sync, from `pingSocket` (the engine's receive socket, where the /pongs
+ *        arrive) to their host's `clockSyncPort`, to keep clock offsets current,
+ *        and every statsIntervalMs it closes each stream's telemetry interval.
+ *
+ *        Multicast destinations need nothing special here beyond the socket's
+ *        TTL, interface and loopback options (setMulticastOptions()).
  */
 class OSCMessageSenderThread : public juce::Thread
 {
 public:
-    OSCMessageSenderThread(juce::OSCSender& sender,
-                           std::queue<OSCTransportMessage>& messageQueue,
-                           juce::CriticalSection& queueLock)
+    // pingSocket must outlive the thread
+    OSCMessageSenderThread(juce::DatagramSocket& pingSocketToUse, int clockSyncPortToUse)
         : juce::Thread("OSC Message Sender Thread"),
-          oscSender(sender),
-          oscMessageQueue(messageQueue),
-          oscQueueLock(queueLock)
+          pingSocket(pingSocketToUse),
+          clockSyncPort(clockSyncPortToUse)
     {
+        OSCDestinationSet::makeNonBlocking(socket);
+        OSCDestinationSet::applyMulticastOptions(socket, multicastOptions);
     }
 
     void run() override
     {
+        auto nextReportTime = juce::Time::getMillisecondCounter() + wakeReportIntervalMs;
+        auto nextPingTime = juce::Time::getMillisecondCounter();
+        auto nextStatsTime = juce::Time::getMillisecondCounter() + statsIntervalMs;
+
         while (!threadShouldExit())
         {
-            OSCTransportMessage msg;
-            bool messageAvailable = false;
-
             {
-                const juce::ScopedLock lock(oscQueueLock);
-                if (!oscMessageQueue.empty())
+                const juce::ScopedLock sl(streamsLock);
+
+                for (auto* stream : streams)
+                    stream->sendPending(socket);
+
+                // Transport first; pings never delay an update
+                const auto now = juce::Time::getMillisecondCounter();
+
+                if ((juce::int32) (now - nextPingTime) >= 0)
                 {
-                    msg = oscMessageQueue.front();
-                    oscMessageQueue.pop();
-                    messageAvailable = true;
-                }
-            }
+                    for (auto* stream : streams)
+                        stream->sendPings(pingSocket, clockSyncPort);
 
-            if (messageAvailable)
-            {
-                if (!oscSender.send("/play", msg.isPlaying ? 1 : 0))
-                    DBG("Failed to send /play message");
+                    nextPingTime = now + pingIntervalMs;
+                }
 
-                if (!oscSender.send("/tempo", msg.tempo))
-                    DBG("Failed to send /tempo message");
+                if ((juce::int32) (now - nextStatsTime) >= 0)
+                {
+                    for (auto* stream : streams)
+                        stream->sendTelemetry(socket);
 
-                if (!oscSender.send("/position", msg.position))
-                    DBG("Failed to send /position message");
+                    nextStatsTime = now + statsIntervalMs;
+                }
             }
-            else
+
+            // Park until an audio thread signals; the timeout only bounds how
+            // long a shutdown request can go unnoticed.
+            workAvailable.wait(parkTimeoutMs);
+
+            if (juce::Time::getMillisecondCounter() >= nextReportTime)
             {
-                wait(5);
+                const auto stats = workAvailable.getWakeLatencyStats();
+                DBG("OSC sender wake latency: avg " + juce::String(stats.averageNs / 1000.0, 1) + " us, max "
+                    + juce::String(stats.maxNs / 1000.0, 1) + " us over " + juce::String((juce::int64) stats.numWakes) + " wakes");
+                juce::ignoreUnused(stats);
+                nextReportTime += wakeReportIntervalMs;
             }
         }
     }
 
+    // Once removeStream() returns, the thread will not touch that stream again
+    void addStream(TransportStream& stream)
+    {
+        const juce::ScopedLock sl(streamsLock);
+        streams.addIfNotAlreadyThere(&stream);
+    }
+
+    void removeStream(TransportStream& stream)
+    {
+        const juce::ScopedLock sl(streamsLock);
+        streams.removeFirstMatchingValue(&stream);
+    }
+
+    // Called from processBlock after publishing or queueing. Realtime-safe, and
+    // safe from several audio threads at once.
+    void notifyWorkAvailable() noexcept { workAvailable.signal(); }
+
+    // Wakes the thread straight away so stopThread() doesn't have to wait out the park timeout
+    void stopSending(int timeoutMs)
+    {
+        signalThreadShouldExit();
+        workAvailable.signal();
+        stopThread(timeoutMs);
+    }
+
+    RealtimeSignal::WakeLatencyStats getWakeLatencyStats() const { return workAvailable.getWakeLatencyStats(); }
+
+    bool isSocketOpen() const { return socket.getRawSocketHandle() >= 0; }
+
+    // Applies to every multicast destination of every stream. Any thread; the
+    // options are socket state, so a send in progress is unaffected.
+    bool setMulticastOptions(const MulticastOptions& options)
+    {
+        const juce::ScopedLock sl(multicastLock);
+        multicastOptions = options;
+        return OSCDestinationSet::applyMulticastOptions(socket, options);
+    }
+
+    MulticastOptions getMulticastOptions() const
+    {
+        const juce::ScopedLock sl(multicastLock);
+        return multicastOptions;
+    }
+
 private:
-    juce::OSCSender& oscSender;
-    std::queue<OSCTransportMessage>& oscMessageQueue;
-    juce::CriticalSection& oscQueueLock;
+    static constexpr int parkTimeoutMs = 500;
+    static constexpr juce::uint32 pingIntervalMs = 500;
+    static constexpr juce::uint32 statsIntervalMs = 1000;
+    static constexpr juce::uint32 wakeReportIntervalMs = 10000;
+
+    RealtimeSignal workAvailable;
+    juce::DatagramSocket socket;
+    juce::DatagramSocket& pingSocket;
+    const int clockSyncPort;
+
+    juce::CriticalSection streamsLock; // Sender thread vs. instances coming and going; never the audio thread
+    juce::Array<TransportStream*> streams;
+
+    juce::CriticalSection multicastLock;
+    MulticastOptions multicastOptions;
 };
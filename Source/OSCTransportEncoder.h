@@ -0,0 +1,305 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include "OSCTransportMessage.h"
+#include "TransportClock.h"
+
+/**
+ * @class OSCPacketWriter
+ * @brief Writes OSC 1.0 messages and bundles straight into a fixed, reused
+ *        byte buffer: padded address, type tag string and big-endian
+ *        arguments. Nothing is allocated, and an oversize packet is flagged
+ *        rather than grown.
+ */
+class OSCPacketWriter
+{
+public:
+    static constexpr size_t maxPacketSize = 1024;
+
+    void reset() noexcept
+    {
+        size = 0;
+        overflowed = false;
+        messageStart = noMessage;
+    }
+
+    void beginBundle(uint64_t timeTag) noexcept
+    {
+        writeBytes("#bundle", 8);
+        writeUInt64(timeTag);
+        inBundle = true;
+    }
+
+    void endBundle() noexcept       { inBundle = false; }
+
+    // `typeTags` excludes the leading comma, e.g. "ii" for two int32 arguments.
+    void beginMessage(const char* address, const char* typeTags) noexcept
+    {
+        beginMessage("", address, typeTags);
+    }
+
+    // As above, with `prefix` written in front of the address ("/deck2" + "/play")
+    void beginMessage(const char* prefix, const char* address, const char* typeTags) noexcept
+    {
+        if (inBundle)
+        {
+            messageStart = size;
+            writeUInt32(0); // Element size, patched in endMessage()
+        }
+
+        writeBytes(prefix, std::strlen(prefix));
+        writePaddedString(address);
+
+        char tags[16] = { ',' };
+        std::strncpy(tags + 1, typeTags, sizeof(tags) - 2);
+        writePaddedString(tags);
+    }
+
+    void endMessage() noexcept
+    {
+        if (messageStart == noMessage || overflowed)
+            return;
+
+        const auto elementSize = static_cast<uint32_t>(size - messageStart - 4);
+        storeBigEndian(buffer.data() + messageStart, elementSize);
+        messageStart = noMessage;
+    }
+
+    void addInt32(int32_t value) noexcept       { writeUInt32(static_cast<uint32_t>(value)); }
+
+    void addFloat32(float value) noexcept
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        writeUInt32(bits);
+    }
+
+    void addString(const char* text) noexcept   { writePaddedString(text); }
+
+    const char* getData() const noexcept    { return buffer.data(); }
+    size_t getSize() const noexcept         { return overflowed ? 0 : size; }
+    bool hasOverflowed() const noexcept     { return overflowed; }
+
+private:
+    static constexpr size_t noMessage = ~static_cast<size_t>(0);
+
+    static void storeBigEndian(char* dest, uint32_t value) noexcept
+    {
+        dest[0] = static_cast<char>(value >> 24);
+        dest[1] = static_cast<char>(value >> 16);
+        dest[2] = static_cast<char>(value >> 8);
+        dest[3] = static_cast<char>(value);
+    }
+
+    void writeBytes(const char* data, size_t numBytes) noexcept
+    {
+        if (size + numBytes > maxPacketSize)
+        {
+            overflowed = true;
+            return;
+        }
+
+        std::memcpy(buffer.data() + size, data, numBytes);
+        size += numBytes;
+    }
+
+    void writeUInt32(uint32_t value) noexcept
+    {
+        char bytes[4];
+        storeBigEndian(bytes, value);
+        writeBytes(bytes, 4);
+    }
+
+    void writeUInt64(uint64_t value) noexcept
+    {
+        writeUInt32(static_cast<uint32_t>(value >> 32));
+        writeUInt32(static_cast<uint32_t>(value));
+    }
+
+    // OSC strings are null terminated and padded with nulls to a multiple of 4.
+    // Padding is worked out from the message start, so a prefix written just
+    // before the address is counted as part of the same string.
+    void writePaddedString(const char* text) noexcept
+    {
+        static constexpr char zeros[4] = {};
+        writeBytes(text, std::strlen(text));
+        writeBytes(zeros, 4 - (size & 3));
+    }
+
+    std::array<char, maxPacketSize> buffer {};
+    size_t size = 0;
+    size_t messageStart = noMessage;
+    bool inBundle = false;
+    bool overflowed = false;
+};
+
+/**
+ * @class OSCTransportEncoder
+ * @brief Encodes our fixed transport message set (/play, /tempo, /position,
+ *        /timestamp) without going through juce::OSCMessage, either as one
+ *        timetagged bundle or as individual messages. An optional address
+ *        prefix ("/deck2/play") tells several streams apart at one receiver.
+ *
+ *        The context messages carry the rest of the host's position info and
+ *        are only added when the caller asks:
+ *
+ *            /timesig    i numerator  i denominator
+ *            /loop       i looping  f startPpq  f endPpq
+ *            /bar        f startPpq  i barCount (-1 = unknown)
+ *            /framerate  f fps (0 = unknown)  i dropFrame
+ *            /record     i recording
+ */
+class OSCTransportEncoder
+{
+public:
+    static constexpr size_t maxPrefixLength = 31;
+
+    // `prefix` is empty or starts with '/' and has no trailing '/'; longer ones are truncated
+    void setAddressPrefix(const char* prefix) noexcept
+    {
+        std::strncpy(addressPrefix, prefix, maxPrefixLength);
+        addressPrefix[maxPrefixLength] = 0;
+    }
+
+    enum class Field { play, tempo, position, timestamp, timeSignature, loop, bar, frameRate, record };
+    static constexpr Field allFields[] = { Field::play, Field::tempo, Field::position, Field::timestamp };
+    static constexpr Field contextFields[] = { Field::timeSignature, Field::loop, Field::bar, Field::frameRate, Field::record };
+
+    // The timetag is the snapshot's own time, not the time we got round to sending it
+    const OSCPacketWriter& encodeBundle(const OSCTransportMessage& msg, bool includeContext = false) noexcept
+    {
+        writer.reset();
+        writer.beginBundle(TransportClock::nsToTimeTag(msg.hostTimeNs));
+
+        for (auto field : allFields)
+            writeField(field, msg);
+
+        if (includeContext)
+            for (auto field : contextFields)
+                writeField(field, msg);
+
+        writer.endBundle();
+        return writer;
+    }
+
+    const OSCPacketWriter& encodeMessage(Field field, const OSCTransportMessage& msg) noexcept
+    {
+        writer.reset();
+        writeField(field, msg);
+        return writer;
+    }
+
+    // Clock sync, never prefixed. /ping carries the token identifying the link
+    // and our send time (t1); /pong goes back to where the ping came from,
+    // echoes the token and t1 and adds the peer's receive (t2) and send (t3) times.
+    const OSCPacketWriter& encodePing(int32_t token, uint64_t t1) noexcept
+    {
+        writer.reset();
+        writer.beginMessage("/ping", "iii");
+        writer.addInt32(token);
+        addTime(t1);
+        writer.endMessage();
+        return writer;
+    }
+
+    const OSCPacketWriter& encodePong(int32_t token, uint64_t t1, uint64_t t2, uint64_t t3) noexcept
+    {
+        writer.reset();
+        writer.beginMessage("/pong", "iiiiiii");
+        writer.addInt32(token);
+        addTime(t1);
+        addTime(t2);
+        addTime(t3);
+        writer.endMessage();
+        return writer;
+    }
+
+    static const char* getAddress(Field field) noexcept
+    {
+        switch (field)
+        {
+            case Field::play:      return "/play";
+            case Field::tempo:     return "/tempo";
+            case Field::position:  return "/position";
+            case Field::timestamp: return "/timestamp";
+            case Field::timeSignature: return "/timesig";
+            case Field::loop:      return "/loop";
+            case Field::bar:       return "/bar";
+            case Field::frameRate: return "/framerate";
+            case Field::record:    return "/record";
+        }
+
+        return "";
+    }
+
+private:
+    void addTime(uint64_t ns) noexcept
+    {
+        writer.addInt32(TransportClock::highWord(ns));
+        writer.addInt32(TransportClock::lowWord(ns));
+    }
+
+    void writeField(Field field, const OSCTransportMessage& msg) noexcept
+    {
+        switch (field)
+        {
+            case Field::play:
+                writer.beginMessage(addressPrefix, getAddress(field), "i");
+                writer.addInt32(msg.isPlaying ? 1 : 0);
+                break;
+
+            case Field::tempo:
+                writer.beginMessage(addressPrefix, getAddress(field), "f");
+                writer.addFloat32(static_cast<float>(msg.tempo));
+                break;
+
+            case Field::position:
+                writer.beginMessage(addressPrefix, getAddress(field), "f");
+                writer.addFloat32(static_cast<float>(msg.position));
+                break;
+
+            case Field::timestamp:
+                writer.beginMessage(addressPrefix, getAddress(field), "ii");
+                addTime(msg.hostTimeNs);
+                break;
+
+            case Field::timeSignature:
+                writer.beginMessage(addressPrefix, getAddress(field), "ii");
+                writer.addInt32(msg.context.timeSigNumerator);
+                writer.addInt32(msg.context.timeSigDenominator);
+                break;
+
+            case Field::loop:
+                writer.beginMessage(addressPrefix, getAddress(field), "iff");
+                writer.addInt32(msg.context.isLooping ? 1 : 0);
+                writer.addFloat32(static_cast<float>(msg.context.loopStartPpq));
+                writer.addFloat32(static_cast<float>(msg.context.loopEndPpq));
+                break;
+
+            case Field::bar:
+                writer.beginMessage(addressPrefix, getAddress(field), "fi");
+                writer.addFloat32(static_cast<float>(msg.context.barStartPpq));
+                writer.addInt32(static_cast<int32_t>(std::clamp<int64_t>(msg.context.barCount, -1, INT32_MAX)));
+                break;
+
+            case Field::frameRate:
+                writer.beginMessage(addressPrefix, getAddress(field), "fi");
+                writer.addFloat32(static_cast<float>(msg.context.frameRate));
+                writer.addInt32(msg.context.isDropFrame ? 1 : 0);
+                break;
+
+            case Field::record:
+                writer.beginMessage(addressPrefix, getAddress(field), "i");
+                writer.addInt32(msg.context.isRecording ? 1 : 0);
+                break;
+        }
+
+        writer.endMessage();
+    }
+
+    OSCPacketWriter writer;
+    char addressPrefix[maxPrefixLength + 1] {};
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// The slower-moving half of the host's PositionInfo: time signature, loop,
+// bar, frame rate and record state. It goes out with an update only when it
+// changes or on a keyframe, so it costs nothing per update.
+struct TransportContext
+{
+    int timeSigNumerator = 4;
+    int timeSigDenominator = 4;
+
+    bool isLooping = false;
+    double loopStartPpq = 0.0;
+    double loopEndPpq = 0.0;
+
+    double barStartPpq = 0.0;   // Start of the bar the position is in
+    int64_t barCount = -1;      // Bars before that one, from the host; -1 if it doesn't say
+
+    double frameRate = 0.0;     // Effective frames per second (29.97...), 0 if unknown
+    bool isDropFrame = false;
+    bool isRecording = false;
+
+    bool operator==(const TransportContext& other) const noexcept
+    {
+        return timeSigNumerator == other.timeSigNumerator && timeSigDenominator == other.timeSigDenominator
+            && isLooping == other.isLooping && loopStartPpq == other.loopStartPpq && loopEndPpq == other.loopEndPpq
+            && barStartPpq == other.barStartPpq && barCount == other.barCount
+            && frameRate == other.frameRate && isDropFrame == other.isDropFrame && isRecording == other.isRecording;
+    }
+
+    bool operator!=(const TransportContext& other) const noexcept   { return !operator==(other); }
+
+    double getBeatLengthPpq() const noexcept    { return 4.0 / (timeSigDenominator > 0 ? timeSigDenominator : 4); }
+    double getBarLengthPpq() const noexcept     { return getBeatLengthPpq() * (timeSigNumerator > 0 ? timeSigNumerator : 4); }
+
+    struct BarBeat
+    {
+        int bar = 1, beat = 1, sixteenth = 1; // All 1-based; beats are of the denominator's note value
+    };
+
+    // Counts from the host's bar start when it gave one, so earlier time
+    // signature changes are allowed for; otherwise assumes this signature
+    // throughout. Pre-roll shows as 1 | 1 | 1.
+    BarBeat getBarBeatAt(double ppq) const noexcept
+    {
+        const double barLength = getBarLengthPpq();
+        const double beatLength = getBeatLengthPpq();
+        const bool hasBarStart = barCount >= 0;
+
+        if (!hasBarStart && ppq < 0.0)
+            return {};
+
+        const double barsFromStart = std::floor(((hasBarStart ? ppq - barStartPpq : ppq) + 1.0e-9) / barLength);
+        const double barStart = (hasBarStart ? barStartPpq : 0.0) + barsFromStart * barLength;
+        const double intoBar = std::max(0.0, ppq - barStart);
+        const double intoBeat = std::fmod(intoBar, beatLength);
+
+        BarBeat b;
+        b.bar = std::max(1, static_cast<int>((hasBarStart ? static_cast<double>(barCount) : 0.0) + barsFromStart) + 1);
+        b.beat = std::min(static_cast<int>(intoBar / beatLength + 1.0e-9), timeSigNumerator - 1) + 1;
+        b.sixteenth = static_cast<int>(intoBeat * 4.0 + 1.0e-9) + 1;
+        return b;
+    }
+
+    // The inverse, for receivers that get bar | beat | sixteenth (Ableton's
+    // /position). Assumes this signature from the start of the song.
+    double getPpqAt(int bar, int beat, int sixteenth) const noexcept
+    {
+        return (bar - 1) * getBarLengthPpq() + (beat - 1) * getBeatLengthPpq() + (sixteenth - 1) * 0.25;
+    }
+};
+
+// One transport snapshot as handed from processBlock to the sender thread.
+// Kept free of JUCE types so encoders and receivers can share it.
+struct OSCTransportMessage
+{
+    bool isPlaying = false;
+    double tempo = 120.0;   // Full precision here; the OSC encoder narrows to float32 on the wire
+    double position = 0.0;  // ppq
+
+    uint64_t hostTimeNs = 0;    // When `position` was true, in TransportClock::nowNs() terms
+    int64_t timeInSamples = 0;  // Host timeline sample the snapshot refers to
+    int sampleOffset = 0;       // Sample within the processBlock call the snapshot was taken at
+    uint64_t publishedNs = 0;   // TransportClock time processBlock handed it over, for latency telemetry
+    uint64_t sequence = 0;      // One more for every snapshot processBlock makes; the order the sender keeps to
+
+    TransportContext context;   // Always filled in; the sender decides whether it goes on the wire
+};
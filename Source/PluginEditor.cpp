@@ -1,8 +1,8 @@
 #include "PluginEditor.h"
 
 
-// BPM Box
-void TransportSenderV1AudioProcessorEditor::paint(juce::Graphics& g)
+// Static background: gradient, boxes, outlines and footer. Only rebuilt when the layout changes.
+void TransportSenderV1AudioProcessorEditor::drawStaticBackground(juce::Graphics& g)
 {
     // Create a more subtle gradient (dark grey to black)
         juce::ColourGradient backgroundGradient(
@@ -40,25 +40,9 @@ void TransportSenderV1AudioProcessorEditor::paint(juce::Graphics& g)
     // ---- Add Static Text at Bottom Right ----
     g.setColour(juce::Colours::goldenrod);
 
-    // Corrected font creation using FontOptions (JUCE 8+)
-    juce::FontOptions fontOptions;
-    fontOptions = fontOptions.withPointHeight(12.0f);  // Set font size
-
-    juce::Font footerFont(fontOptions);  // Create font with options
-    footerFont.setTypefaceName("Arial"); // Set typeface name explicitly
-
+    // Font and strings are built once, see makeFooterFont() and the footer members
     g.setFont(footerFont);
 
-    // UTF-8 Encoded String (First Part with Copyright Symbol)
-    const char* utf8Text1 = u8"Alex Fortunato Music ©";
-    juce::String footerText1 = juce::String::fromUTF8(utf8Text1, static_cast<int>(std::strlen(utf8Text1)));
-
-    // Second part of string ("2025") Separately
-    juce::String footerText2 = " 2025";
-
-    // New Website Label
-    juce::String websiteText = "alexfortunatomusic.com   ";
-
     // Adjust Footer Positioning
     int windowWidth = getWidth();
     int windowHeight = getHeight();
@@ -79,6 +63,43 @@ void TransportSenderV1AudioProcessorEditor::paint(juce::Graphics& g)
 
 }
 
+juce::Font TransportSenderV1AudioProcessorEditor::makeFooterFont()
+{
+    // Corrected font creation using FontOptions (JUCE 8+)
+    juce::FontOptions fontOptions;
+    fontOptions = fontOptions.withPointHeight(12.0f);  // Set font size
+
+    juce::Font font(fontOptions);  // Create font with options
+    font.setTypefaceName("Arial"); // Set typeface name explicitly
+    return font;
+}
+
+// BPM Box
+void TransportSenderV1AudioProcessorEditor::paint(juce::Graphics& g)
+{
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    // Render the background at the display's pixel scale so the cache stays sharp
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    const int imageWidth = juce::roundToInt(getWidth() * scale);
+    const int imageHeight = juce::roundToInt(getHeight() * scale);
+
+    if (backgroundCache.isNull() || backgroundCache.getWidth() != imageWidth || backgroundCache.getHeight() != imageHeight)
+    {
+        backgroundCache = juce::Image(juce::Image::RGB, juce::jmax(1, imageWidth), juce::jmax(1, imageHeight), false);
+        juce::Graphics imageGraphics(backgroundCache);
+        imageGraphics.addTransform(juce::AffineTransform::scale(scale));
+        drawStaticBackground(imageGraphics);
+    }
+
+    g.drawImageTransformed(backgroundCache, juce::AffineTransform::scale(1.0f / scale));
+
+    lastPaintMs = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
+
+    if (lastPaintMs > paintBudgetMs)
+        DBG("Editor paint took " + juce::String(lastPaintMs, 3) + " ms, over the " + juce::String(paintBudgetMs) + " ms budget");
+}
+
 //==============================================================================
 void TransportSenderV1AudioProcessorEditor::buttonClicked(juce::Button* button)
 {
@@ -117,6 +138,11 @@ TransportSenderV1AudioProcessorEditor::TransportSenderV1AudioProcessorEditor(Tra
 {
 
     playButton.addListener(this);
+    //  set playButton text to "▶"
+    playButton.setButtonText(juce::CharPointer_UTF8("▶"));
+    // Increase Font Size
+    //playButton.setFont(juce::Font(30.0f, juce::Font::bold)); // Adjust size as needed
+    playButton.setLookAndFeel(&customLookAndFeel);
     addAndMakeVisible(playButton);
     playButton.addAndMakeVisible(isPlayingLabel); // Add label inside button
     playButton.onClick = [this] { togglePlayState(); };
@@ -131,6 +157,9 @@ TransportSenderV1AudioProcessorEditor::TransportSenderV1AudioProcessorEditor(Tra
     bpmTextLabel.setColour(juce::Label::textColourId, juce::Colours::white);
 
     addAndMakeVisible(positionLabel);
+
+    for (auto* label : { &isPlayingLabel, &bpmLabel, &positionLabel })
+        label->setJustificationType(juce::Justification::centred);
     
     // Initialize and style OSC Status Label - chatgpt
         addAndMakeVisible(oscStatusLabel);
@@ -138,6 +167,24 @@ TransportSenderV1AudioProcessorEditor::TransportSenderV1AudioProcessorEditor(Tra
         oscStatusLabel.setJustificationType(juce::Justification::centredLeft);
         oscStatusLabel.setColour(juce::Label::textColourId, juce::Colours::white);
     
+    // Telemetry panel: two small lines, refreshed when a new report arrives
+        addAndMakeVisible(statsLabel);
+        statsLabel.setFont(juce::Font(12.0f, juce::Font::plain));
+        statsLabel.setJustificationType(juce::Justification::topLeft);
+        statsLabel.setColour(juce::Label::textColourId, juce::Colours::lightgrey);
+    
+    // Transport log on/off; the timer keeps it in step with the processor
+    addAndMakeVisible(recordButton);
+    recordButton.setClickingTogglesState(true);
+    recordButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::darkred);
+    recordButton.onClick = [this]
+    {
+        if (recordButton.getToggleState())
+            recordButton.setToggleState(audioProcessor.startTransportRecording(), juce::dontSendNotification);
+        else
+            audioProcessor.stopTransportRecording();
+    };
+    
     // Text label above position label
     addAndMakeVisible(positionTextLabel);
     positionTextLabel.setText("Position", juce::dontSendNotification);
@@ -274,6 +321,8 @@ void TransportSenderV1AudioProcessorEditor::resized()
         boxHeight
     );
     bpmLabel.setBounds(bpmBox); // Position BPM label inside BPM box
+
+    recordButton.setBounds(bpmBox.getRight() + padding, bpmBox.getY(), 50, boxHeight - 1);
     
     // Position bpmTextLabel directly above the BPM box
     bpmTextLabel.setBounds(
@@ -294,30 +343,94 @@ void TransportSenderV1AudioProcessorEditor::resized()
         bpmBox.getRight() - playButton.getX(), // Stretch to the right end of the last box
         20                                 // Set height
     );
+
+    statsLabel.setBounds(
+        oscStatusLabel.getX(),
+        oscStatusLabel.getBottom(),
+        getWidth() - oscStatusLabel.getX() - margin,
+        32
+    );
  
 
-    repaint();
+    // Layout changed: the cached background has to be redrawn (resizing repaints anyway)
+    backgroundCache = {};
 }
 
-// Function to update labels based on received OSC messages
+// Function to update labels based on received OSC messages (message thread only)
 void TransportSenderV1AudioProcessorEditor::updateTransportLabels()
 {
-    juce::MessageManager::callAsync([this]
+    const auto state = processorRef.getSlaveTransportState();
+
+    tempoLabel.setText("Tempo: " + juce::String(state.bpm), juce::dontSendNotification);
+
+    // ✅ Ensure position updates properly
+    juce::String locationText = "Location: " + juce::String(state.bar) + " | "
+                                + juce::String(state.beat) + " | "
+                                + juce::String(state.subBeat);
+    locationLabel.setText(locationText, juce::dontSendNotification);
+
+    juce::String playText = state.isPlaying ? "Playing" : "Stopped";
+
+    if (state.isPlaying)
     {
-        const auto& state = processorRef.getSlaveTransportState();
+        const auto lock = processorRef.getSlaveLockStatus();
+
+        if (lock.lock == TransportPhaseTracker::Lock::locked)
+            playText << " (locked, " << juce::String(lock.phaseErrorMs, 2) << " ms)";
+        else if (lock.lock == TransportPhaseTracker::Lock::acquiring)
+            playText << " (locking " << juce::roundToInt(lock.confidence * 100.0) << "%)";
+    }
+
+    playStateLabel.setText("Play State: " + playText, juce::dontSendNotification);
+}
 
-        tempoLabel.setText("Tempo: " + juce::String(state.bpm), juce::dontSendNotification);
+// Called every display frame; does nothing unless new OSC arrived since the last one
+void TransportSenderV1AudioProcessorEditor::refreshTransportLabelsIfChanged()
+{
+    if (!processorRef.takeSlaveStateChanged())
+        return;
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    updateTransportLabels();
+    ++transportUiRefreshesThisPeriod;
+    addTransportUiTime(startTicks);
+}
 
-        // ✅ Ensure position updates properly
-        juce::String locationText = "Location: " + juce::String(state.bar) + " | "
-                                    + juce::String(state.beat) + " | "
-                                    + juce::String(state.subBeat);
-        locationLabel.setText(locationText, juce::dontSendNotification);
-        locationLabel.repaint(); // ✅ Force UI refresh
+// The path the per-frame refresh replaced: the processor posts this once per
+// incoming packet, and it posts the label update again
+void TransportSenderV1AudioProcessorEditor::refreshTransportLabelsLegacy()
+{
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    juce::MessageManager::callAsync([safeThis = juce::Component::SafePointer<TransportSenderV1AudioProcessorEditor>(this)]
+    {
+        if (safeThis == nullptr)
+            return;
 
-        juce::String playText = state.isPlaying ? "Playing" : "Stopped";
-        playStateLabel.setText("Play State: " + playText, juce::dontSendNotification);
+        const auto labelTicks = juce::Time::getHighResolutionTicks();
+        safeThis->updateTransportLabels();
+        ++safeThis->transportUiRefreshesThisPeriod;
+        safeThis->addTransportUiTime(labelTicks);
     });
+
+    addTransportUiTime(startTicks);
+}
+
+void TransportSenderV1AudioProcessorEditor::addTransportUiTime(juce::int64 startTicks)
+{
+    transportUiSecondsThisPeriod += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+    const auto now = juce::Time::getMillisecondCounter();
+    const auto periodMs = now - transportUiPeriodStartMs;
+
+    if (periodMs >= 1000)
+    {
+        transportUiMsPerSecond = transportUiSecondsThisPeriod * 1000.0 * (1000.0 / periodMs);
+        transportUiRefreshesPerSecond = juce::roundToInt(transportUiRefreshesThisPeriod * (1000.0 / periodMs));
+        transportUiSecondsThisPeriod = 0.0;
+        transportUiRefreshesThisPeriod = 0;
+        transportUiPeriodStartMs = now;
+    }
 }
 
 
@@ -329,62 +442,127 @@ void TransportSenderV1AudioProcessorEditor::updateTransportLabels()
 
 void TransportSenderV1AudioProcessorEditor::timerCallback()
 {
+    const auto startTicks = juce::Time::getHighResolutionTicks();
     updateLabels();
+    updateStatsLabel();
+    addTransportUiTime(startTicks);
     // updateOscMessageLabel(); // Incoming messages
 }
 
+// Only rebuilds the text when the sender thread has published a new report (once a second)
+void TransportSenderV1AudioProcessorEditor::updateStatsLabel()
+{
+    const auto version = audioProcessor.getTelemetryReportVersion();
+
+    if (version == displayedStatsVersion)
+        return;
+
+    displayedStatsVersion = version;
+    const auto r = audioProcessor.getTelemetryReport();
+
+    juce::String text;
+    text << "Sent " << juce::String(r.packetsPerSecond, 1) << "/s  links " << r.numHealthyDestinations << "/" << r.numDestinations
+         << "  fail " << juce::String((juce::int64) r.sendFailures) << "  drops " << juce::String((juce::int64) r.queueDrops)
+         << "  queue max " << r.queueHighWater << "\n"
+         << "Wire p50 " << juce::String(r.wireLatency.p50Ns / 1.0e6, 2) << " / p99 " << juce::String(r.wireLatency.p99Ns / 1.0e6, 2)
+         << " ms   Audio p99 " << juce::String(r.processTime.p99Ns / 1.0e3, 0) << " us ("
+         << juce::String(r.dspLoadPercent, 2) << "%)   UI " << juce::String(transportUiMsPerSecond, 2)
+         << " ms/s (" << transportUiRefreshesPerSecond << " refreshes)";
+
+    statsLabel.setText(text, juce::dontSendNotification);
+}
+
 void TransportSenderV1AudioProcessorEditor::updateLabels()
 {
     auto state = audioProcessor.getTransportState();
-    
-    //  set playButton text to "▶"
-    playButton.setButtonText(juce::CharPointer_UTF8("▶"));
-    // Increase Font Size
-    //playButton.setFont(juce::Font(30.0f, juce::Font::bold)); // Adjust size as needed
-    playButton.setLookAndFeel(&customLookAndFeel);
-    
-    // Change playButton text color instead of button color
-    playButton.setColour(juce::TextButton::textColourOffId, state.isPlaying ? juce::Colours::chartreuse : juce::Colours::red);
-    // Change playButton Background Color
-    playButton.setColour(juce::TextButton::buttonColourId, state.isPlaying ? juce::Colours::darkgrey : juce::Colours::black);
 
-    
-    // Update transport state labels
-    isPlayingLabel.setText(state.isPlaying ? "Playing" : "Paused", juce::dontSendNotification);
-    isPlayingLabel.setJustificationType(juce::Justification::centred);
+    // Only touch components whose value actually changed; setColour and
+    // setText each trigger repaints even when nothing visible is different.
+    if (!displayed.isValid || state.isPlaying != displayed.isPlaying)
+    {
+        // Change playButton text color instead of button color
+        playButton.setColour(juce::TextButton::textColourOffId, state.isPlaying ? juce::Colours::chartreuse : juce::Colours::red);
+        // Change playButton Background Color
+        playButton.setColour(juce::TextButton::buttonColourId, state.isPlaying ? juce::Colours::darkgrey : juce::Colours::black);
+
+        // Update transport state labels
+        isPlayingLabel.setText(state.isPlaying ? "Playing" : "Paused", juce::dontSendNotification);
+        displayed.isPlaying = state.isPlaying;
+    }
 
-    
-    
-    bpmLabel.setText(juce::String(state.bpm, 2), juce::dontSendNotification);
-    bpmLabel.setJustificationType(juce::Justification::centred);
+    const auto bpmHundredths = juce::roundToInt(state.bpm * 100.0);
 
-    
-    int bar = static_cast<int>(state.ppqPosition / state.timeSigNumerator) + 1;
-    int beat = static_cast<int>(state.ppqPosition) % state.timeSigNumerator + 1;
-    positionLabel.setText(juce::String(bar) + " | " + juce::String(beat) + " | " +
-                          juce::String((static_cast<int>(state.ppqPosition * 4) % 4) + 1),
-                          juce::dontSendNotification);
-    positionLabel.setJustificationType(juce::Justification::centred);
-    
+    if (!displayed.isValid || bpmHundredths != displayed.bpmHundredths)
+    {
+        bpmLabel.setText(juce::String(state.bpm, 2), juce::dontSendNotification);
+        displayed.bpmHundredths = bpmHundredths;
+    }
 
-    
-    
-    
-    
+    // Honours the host's time signature and bar start, so 7/8 reads 1 | 7 | 2 at its last 16th
+    const auto barBeat = state.getBarBeatAt(state.ppqPosition);
+    int bar = barBeat.bar;
+    int beat = barBeat.beat;
+    int sixteenth = barBeat.sixteenth;
+
+    if (!displayed.isValid || bar != displayed.bar || beat != displayed.beat || sixteenth != displayed.sixteenth)
+    {
+        positionLabel.setText(juce::String(bar) + " | " + juce::String(beat) + " | " + juce::String(sixteenth),
+                              juce::dontSendNotification);
+        displayed.bar = bar;
+        displayed.beat = beat;
+        displayed.sixteenth = sixteenth;
+    }
 
+    const bool isRecording = audioProcessor.isRecordingTransport();
 
-    // Update OSC Status with port
-    if (audioProcessor.isOscConnected())
+    if (!displayed.isValid || isRecording != displayed.isRecording)
     {
-        int port = audioProcessor.getOscPort();
-        oscStatusLabel.setText("OSC Status: Connected to Port " + juce::String(port), juce::dontSendNotification);
-        oscStatusLabel.setColour(juce::Label::textColourId, juce::Colours::chartreuse);
+        recordButton.setToggleState(isRecording, juce::dontSendNotification);
+        displayed.isRecording = isRecording;
     }
-    else
+
+    // Update OSC Status with port; the link state is live, so this follows lookups and failures
+    using LinkState = OSCDestinationSet::LinkState;
+    const auto link = audioProcessor.getOscLinkSummary();
+    const auto linkState = link.state;
+    const int port = audioProcessor.getOscPort();
+
+    // The counts too, so "n of m destinations up" follows a link recovering while still degraded
+    if (!displayed.isValid || linkState != displayed.linkState || port != displayed.oscPort
+        || link.numConnected != displayed.numDestinationsUp || link.numDestinations != displayed.numDestinations)
     {
-        oscStatusLabel.setText("OSC Status: Disconnected", juce::dontSendNotification);
-        oscStatusLabel.setColour(juce::Label::textColourId, juce::Colours::red);
+        juce::String text = "OSC Status: Disconnected";
+        auto colour = juce::Colours::red;
+
+        if (linkState == LinkState::connected)
+        {
+            text = "OSC Status: Connected to Port " + juce::String(port);
+            colour = juce::Colours::chartreuse;
+        }
+        else if (linkState == LinkState::degraded)
+        {
+            text = "OSC Status: " + juce::String(link.numConnected) + " of " + juce::String(link.numDestinations) + " destinations up";
+            colour = juce::Colours::orange;
+        }
+        else if (linkState == LinkState::resolving)
+        {
+            text = "OSC Status: Connecting...";
+            colour = juce::Colours::yellow;
+        }
+        else if (linkState == LinkState::down)
+        {
+            text = "OSC Status: Unreachable, retrying";
+        }
+
+        oscStatusLabel.setText(text, juce::dontSendNotification);
+        oscStatusLabel.setColour(juce::Label::textColourId, colour);
+        displayed.linkState = linkState;
+        displayed.oscPort = port;
+        displayed.numDestinationsUp = link.numConnected;
+        displayed.numDestinations = link.numDestinations;
     }
+
+    displayed.isValid = true;
 }
 
 
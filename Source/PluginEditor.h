@@ -33,11 +33,19 @@ public:
     void buttonClicked(juce::Button*) override;
     void togglePlayState();
     void paint (juce::Graphics&) override;
+    double getLastPaintMilliseconds() const { return lastPaintMs; }
     void resized() override;
     void timerCallback() override;
     void updateLabels();
     void updateOscMessageLabel();
     void updateTransportLabels();
+    void refreshTransportLabelsIfChanged();
+    void refreshTransportLabelsLegacy(); // TRANSPORT_UI_LEGACY_ASYNC only
+
+    // Message-thread time spent on transport UI over the last second, and how
+    // many refreshes it was spread over; shown on the stats line
+    double getTransportUiMillisecondsPerSecond() const { return transportUiMsPerSecond; }
+    int getTransportUiRefreshesPerSecond() const { return transportUiRefreshesPerSecond; }
 
 private:
     
@@ -52,8 +60,12 @@ private:
     
     
     juce::TextButton playButton {"Playing"}; // Triangle play
+    juce::TextButton recordButton {"REC"}; // Toggles the transport log, see startTransportRecording()
     
     juce::Label oscStatusLabel; // Displays OSC connection status
+    juce::Label statsLabel; // Compact send-pipeline telemetry under the status line
+    uint64_t displayedStatsVersion = 0;
+    void updateStatsLabel();
     
     // juce::Label oscMessageLabel; // Label to show received OSC messages
     
@@ -77,6 +89,48 @@ private:
 
     // TransportDisplay transportDisplay; // Embedding Play Button UI
 
+    // Cached rendering: everything static is drawn once into backgroundCache
+    void drawStaticBackground(juce::Graphics&);
+    static juce::Font makeFooterFont();
+
+    juce::Image backgroundCache;
+    const juce::Font footerFont { makeFooterFont() };
+    const juce::String footerText1 { juce::CharPointer_UTF8("Alex Fortunato Music \xc2\xa9") }; // UTF-8 copyright symbol
+    const juce::String footerText2 { " 2025" }; // Second part of string ("2025") Separately
+    const juce::String websiteText { "alexfortunatomusic.com   " };
+
+    static constexpr double paintBudgetMs = 1.0;
+    double lastPaintMs = 0.0;
+
+    // What updateLabels() last put on screen, so unchanged values are skipped
+    struct DisplayedState
+    {
+        bool isValid = false;
+        bool isPlaying = false;
+        int bpmHundredths = 0;
+        int bar = 0, beat = 0, sixteenth = 0;
+        OSCDestinationSet::LinkState linkState = OSCDestinationSet::LinkState::idle;
+        int numDestinationsUp = 0, numDestinations = 0;
+        int oscPort = 0;
+        bool isRecording = false;
+    };
+
+    DisplayedState displayed;
+
+    // Transport UI cost accounting
+    void addTransportUiTime(juce::int64 startTicks);
+    double transportUiSecondsThisPeriod = 0.0;
+    juce::uint32 transportUiPeriodStartMs = juce::Time::getMillisecondCounter();
+    double transportUiMsPerSecond = 0.0;
+    int transportUiRefreshesThisPeriod = 0;
+    int transportUiRefreshesPerSecond = 0;
+
+   #if !TRANSPORT_UI_LEGACY_ASYNC
+    // Incoming OSC only marks the processor's slave state as changed; this
+    // applies it at most once per display frame.
+    juce::VBlankAttachment vBlankAttachment { this, [this] { refreshTransportLabelsIfChanged(); } };
+   #endif
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TransportSenderV1AudioProcessorEditor)
 };
 
@@ -1,6 +1,7 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
-#include "OSCMessageSenderThread.h"
+#include "TransportEngine.h"
+#include "RealtimeSafety.h"
 //
 //==============================================================================
 
@@ -16,47 +17,19 @@ TransportSenderV1AudioProcessor::TransportSenderV1AudioProcessor()
                       )
 #endif
 {
-    if (oscSender.connect("127.0.0.1", 8000)) // Ensure the IP and port match Max
-    {
-        DBG("OSC Sender connected to 127.0.0.1:8000");
-        oscConnected = true; // Set the flag to true
-        setOscPort(8000); // Store the connected port
-    }
-    else
-    {
-        DBG("Error: OSC Sender failed to connect to 127.0.0.1:8000!");
-        oscConnected = false;
-        setOscPort(0); // Reset port to 0 if connection fails
-    }
-    
-    
-    
-    // Connect OSC Receiver to listen for transport messages from Ableton
-    if (oscReceiver.connect(8002)) // Old: if (oscReceiver.connect(8001)) // Explicitly reference oscReceiver
-    {
-        DBG("OSC Receiver connected on port 8002.");
-        
-        oscReceiver.addListener(this, "/play");
-        oscReceiver.addListener(this, "/tempo");
-        oscReceiver.addListener(this, "/position");
-    }
-    else
-    {
-        DBG("Error: OSC Receiver failed to connect!");
-    }
+    // Join the shared engine: its receiver (port 8002, transport from Ableton)
+    // and sender thread now serve this instance too
+    transportEngine->addStream(oscStream);
 
-    // Create and start the OSC sender thread
-    oscThread.reset(new OSCMessageSenderThread(oscSender, oscMessageQueue, oscQueueLock));
-    oscThread->startThread();
+    // Looked up in the background; the editor shows the link state as it changes
+    connectOscSender(); // Ensure the IP and port match Max
 }
 
 TransportSenderV1AudioProcessor::~TransportSenderV1AudioProcessor()
 {
-    if (oscThread)
-    {
-        oscThread->signalThreadShouldExit();
-        oscThread->stopThread(100); // Wait up to 100 ms for it to stop
-    }
+    // After this the shared threads never call back into us; the engine itself
+    // shuts down when the last instance releases it
+    transportEngine->removeStream(oscStream);
 }
 
 
@@ -129,20 +102,24 @@ void TransportSenderV1AudioProcessor::changeProgramName(int index, const juce::S
 // Prepare to play
 void TransportSenderV1AudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    // Calculate the number of samples corresponding to ~33ms (30 fps)
-    samplesPerMessage = sampleRate / 30.0;
-    sampleCounter = 0.0;
-    // Reconnect OSC Sender in case of issues
-    if (!oscSender.connect("127.0.0.1", 8000))
-    {
-        DBG("Error: OSC Sender failed to connect to 127.0.0.1:8000!");
-    }
+    currentSampleRate = sampleRate;
+    processedSeconds = 0.0;
+    rateController.reset(); // First block after this always sends
+    hostClock.reset();
+    midiClock.prepare(sampleRate);
+    midiClockBlockSize = juce::jmax(1, samplesPerBlock);
+    midiClockEvents.ensureSize(MidiClockGenerator::getMaxBytesPerBlock(midiClockBlockSize, sampleRate));
+    binarySequenceResetPending = true;
+    // No socket work here: the connection manager keeps the links up in the background
 }
 
 // Release resources
 void TransportSenderV1AudioProcessor::releaseResources()
 {
-    // No cleanup needed for this simple OSC implementation
+    // With TRANSPORT_REALTIME_CHECKS on, anything processBlock did that it
+    // mustn't is listed on stderr with its call site
+    RealtimeSafety::printNewViolations();
+    jassert(RealtimeSafety::getNumViolations() == 0);
 }
 
 //==============================================================================
@@ -150,8 +127,22 @@ void TransportSenderV1AudioProcessor::releaseResources()
 // Update transport state and send OSC messages
 void TransportSenderV1AudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
-    bool transportChanged = false;
+    const RealtimeSafety::ScopedAudioThread realtimeChecks("processBlock"); // No-op unless TRANSPORT_REALTIME_CHECKS
+    const auto processStartNs = TransportClock::nowNs();
     bool playStateChanged = false;
+    const int numSamples = buffer.getNumSamples();
+
+    // Host time goes out in TransportClock's domain, so it's comparable with
+    // publishedNs and the receiver's arrival stamps. Without it, our own clock.
+    std::optional<uint64_t> hostTimeNs;
+
+    // A play/stop from the editor lands first, so a host play head still has the last word
+    if (const auto request = requestedPlayState.exchange(noPlayRequest, std::memory_order_acquire); request != noPlayRequest)
+    {
+        const bool requestedPlaying = (request == playRequested);
+        playStateChanged = (transportState.isPlaying != requestedPlaying);
+        transportState.isPlaying = requestedPlaying;
+    }
 
     if (auto* playHead = getPlayHead())
     {
@@ -159,6 +150,11 @@ void TransportSenderV1AudioProcessor::processBlock(juce::AudioBuffer<float>& buf
         {
             const auto& posInfo = *position;
 
+            if (auto hostTime = posInfo.getHostTimeNs())
+                hostTimeNs = *hostTime;
+
+            blockTimeInSamples = posInfo.getTimeInSamples().orFallback(blockTimeInSamples + numSamples);
+
             double newPpqPosition = posInfo.getPpqPosition().hasValue() ? *posInfo.getPpqPosition() : 0.0;
             double newBpm = posInfo.getBpm().hasValue() ? *posInfo.getBpm() : 120.0;
             bool newIsPlaying = posInfo.getIsPlaying();
@@ -166,53 +162,97 @@ void TransportSenderV1AudioProcessor::processBlock(juce::AudioBuffer<float>& buf
             if (transportState.isPlaying != newIsPlaying)
                 playStateChanged = true;
 
-            if (transportState.ppqPosition != newPpqPosition ||
-                transportState.bpm != newBpm ||
-                playStateChanged)
-            {
-                transportState.ppqPosition = newPpqPosition;
-                transportState.bpm = newBpm;
-                transportState.isPlaying = newIsPlaying;
-                transportChanged = true;
-            }
+            transportState.ppqPosition = newPpqPosition;
+            transportState.bpm = newBpm;
+            transportState.isPlaying = newIsPlaying;
+            readTransportContext(posInfo, transportState);
         }
     }
 
-    // Accumulate the number of processed samples
-    sampleCounter += buffer.getNumSamples();
+    blockHostTimeNs = hostClock.getBlockTimeNs(hostTimeNs, processStartNs);
 
-    // If enough samples have passed (e.g. ~33ms worth), then queue up an OSC update
-    if (transportState.isPlaying && transportChanged && (sampleCounter >= samplesPerMessage))
-    {
-        // [We’ll push our OSC transport data to a thread-safe queue here instead of sending immediately]
-        OSCTransportMessage msg;
-        msg.isPlaying = transportState.isPlaying;
-        msg.tempo = static_cast<float>(transportState.bpm);
-        msg.position = static_cast<float>(transportState.ppqPosition);
+    // Publish the new state for the editor and any other reader
+    transportSnapshot.publish(transportState);
 
-        {
-            const juce::ScopedLock lock(oscQueueLock);
-            oscMessageQueue.push(msg);
-        }
+    // MIDI beat clock for hardware that only takes MIDI. A block longer than
+    // prepareToPlay promised is clocked in pieces of the promised size, so the
+    // events never outgrow midiClockEvents' reserved storage.
+    const bool midiClockPlaying = transportState.isPlaying && midiClockEnabled.load(std::memory_order_relaxed);
 
-        sampleCounter -= samplesPerMessage; // subtract the interval (or reset to 0)
+    for (int clockStart = 0; clockStart < numSamples; clockStart += midiClockBlockSize)
+    {
+        MidiClockGenerator::Block clockBlock;
+        clockBlock.isPlaying = midiClockPlaying;
+        clockBlock.ppqAtStart = getRateControlState(clockStart).ppq;
+        clockBlock.bpm = transportState.bpm;
+        clockBlock.numSamples = juce::jmin(midiClockBlockSize, numSamples - clockStart);
+        midiClockEvents.clear(); // Keeps its storage
+        midiClock.process(clockBlock, midiClockEvents);
+
+        // The wrappers reserve their own MIDI buffers (2048 bytes in JUCE's), far
+        // more than a block's clock events, so this is a copy into that storage
+        if (!midiClockEvents.isEmpty())
+            midiMessages.addEvents(midiClockEvents, 0, clockBlock.numSamples, clockStart);
     }
 
-    // Always update /play immediately if play state changed
+    const double blockStartSeconds = processedSeconds;
+    processedSeconds += numSamples / currentSampleRate;
+
+    bool publishedUpdate = false;
+
+    // Always update /play immediately if play state changed. This goes first so
+    // that a periodic update later in the same block supersedes it.
     if (playStateChanged)
+        playStateChangePending = true;
+
+    if (playStateChangePending)
     {
         // Push play state change as a separate OSC message if needed.
-        OSCTransportMessage playMsg;
-        playMsg.isPlaying = transportState.isPlaying;
-        playMsg.tempo = static_cast<float>(transportState.bpm);
-        playMsg.position = static_cast<float>(transportState.ppqPosition);
+        OSCTransportMessage playMsg = makeTransportSnapshot(0);
 
-        {
-            const juce::ScopedLock lock(oscQueueLock);
-            oscMessageQueue.push(playMsg);
-        }
+        // Keep it pending if the queue is full; we retry on the next block
+        if (oscStream.pushEvent(playMsg))
+            playStateChangePending = false;
+
+        oscStream.publish(playMsg);
+        rateController.markSent(getRateControlState(0), blockStartSeconds);
+        publishedUpdate = true;
+    }
+
+    // Pick up threshold and keyframe changes made from the UI or host. Never
+    // waits on the writer: if the read races a change, last block's settings stand.
+    auto settings = rateController.getSettings();
+
+    if (rateControlSettings.tryRead(settings))
+        rateController.setSettings(settings);
+
+    // Publish an update only when receivers' extrapolated position would drift
+    // too far, the tempo moves, or a keyframe is due
+    TransportRateController::Reason sendReason;
+    const int dueOffset = rateController.getSendOffset(getRateControlState(0), blockStartSeconds,
+                                                       numSamples, currentSampleRate, sendReason);
+
+    // A new time signature, loop or bar goes out now rather than waiting for the
+    // position to drift; the sender attaches it only because it changed
+    const bool contextChanged = static_cast<const TransportContext&>(transportState) != lastPublishedContext;
+
+    if (dueOffset >= 0 || (contextChanged && !publishedUpdate))
+    {
+        const int offset = juce::jmax(0, dueOffset);
+
+        // Only the newest position matters, so this replaces rather than queues
+        oscStream.publish(makeTransportSnapshot(offset));
+        rateController.markSent(getRateControlState(offset), blockStartSeconds + offset / currentSampleRate);
+        publishedUpdate = true;
     }
 
+    if (publishedUpdate)
+        lastPublishedContext = transportState;
+
+    // Wake the sender thread if there is anything new for it
+    if (publishedUpdate || oscStream.hasPendingEvents())
+        transportEngine->notifyWorkAvailable();
+
     // Keep plugin alive with inaudible signal
     for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
     {
@@ -220,55 +260,192 @@ void TransportSenderV1AudioProcessor::processBlock(juce::AudioBuffer<float>& buf
         for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
             channelData[sample] = 0.0001f;
     }
+
+    oscStream.getTelemetry().recordProcessBlock(TransportClock::nowNs() - processStartNs, numSamples / currentSampleRate);
+}
+
+
+
+
+
+
+// The transport as the rate controller sees it, `sampleOffset` samples into the block
+TransportRateController::State TransportSenderV1AudioProcessor::getRateControlState(int sampleOffset) const
+{
+    TransportRateController::State state;
+    state.isPlaying = transportState.isPlaying;
+    state.bpm = transportState.bpm;
+    state.ppq = transportState.ppqPosition;
+
+    if (state.isPlaying)
+        state.ppq += sampleOffset / currentSampleRate * state.bpm / 60.0;
+
+    return state;
+}
+
+void TransportSenderV1AudioProcessor::setOscSendRateHz(double hz)
+{
+    auto settings = rateControlSettings.read();
+    settings.keyframeIntervalSeconds = 1.0 / juce::jlimit(1.0, 1000.0, hz);
+    rateControlSettings.publish(settings);
 }
 
+// Build a snapshot of the transport as it stands `sampleOffset` samples into
+// the current block, advancing position and host time to that sample.
+OSCTransportMessage TransportSenderV1AudioProcessor::makeTransportSnapshot(int sampleOffset)
+{
+    const double secondsIntoBlock = sampleOffset / currentSampleRate;
+
+    OSCTransportMessage msg;
+    msg.isPlaying = transportState.isPlaying;
+    msg.tempo = transportState.bpm;
+
+    double ppq = transportState.ppqPosition;
+    if (transportState.isPlaying)
+        ppq += secondsIntoBlock * transportState.bpm / 60.0;
+
+    msg.position = ppq;
+    msg.hostTimeNs = blockHostTimeNs + static_cast<uint64_t>(secondsIntoBlock * 1.0e9);
+    msg.timeInSamples = blockTimeInSamples + sampleOffset;
+    msg.sampleOffset = sampleOffset;
+    msg.publishedNs = TransportClock::nowNs();
+    msg.sequence = nextSnapshotSequence++;
+    msg.context = transportState;
+    return msg;
+}
+
+// Everything in PositionInfo besides play state, tempo and position. Fields the
+// host leaves out keep their last value, except the ones that can only be "off".
+void TransportSenderV1AudioProcessor::readTransportContext(const juce::AudioPlayHead::PositionInfo& posInfo, TransportContext& context)
+{
+    if (auto timeSig = posInfo.getTimeSignature())
+    {
+        context.timeSigNumerator = juce::jmax(1, timeSig->numerator);
+        context.timeSigDenominator = juce::jmax(1, timeSig->denominator);
+    }
+
+    context.isLooping = posInfo.getIsLooping();
 
+    if (auto loop = posInfo.getLoopPoints())
+    {
+        context.loopStartPpq = loop->ppqStart;
+        context.loopEndPpq = loop->ppqEnd;
+    }
 
+    context.barStartPpq = posInfo.getPpqPositionOfLastBarStart().orFallback(context.barStartPpq);
+    context.barCount = posInfo.getBarCount().orFallback(-1);
 
+    if (auto frameRate = posInfo.getFrameRate())
+    {
+        context.frameRate = frameRate->getEffectiveRate();
+        context.isDropFrame = frameRate->isDrop();
+    }
+    else
+    {
+        context.frameRate = 0.0;
+        context.isDropFrame = false;
+    }
 
+    context.isRecording = posInfo.getIsRecording();
+}
 
 //==============================================================================
 
 
-// Send OSC messages
-void TransportSenderV1AudioProcessor::sendOSCMessages()
+// Point this instance's stream at the receivers (Max, lighting, video, ...).
+// Returns at once: the engine's connection manager looks them up, and retries
+// with backoff, so this is safe from the constructor and host callbacks.
+bool TransportSenderV1AudioProcessor::connectOscSender()
 {
-    // Attempt to reconnect if sending fails
-    if (!oscSender.send("/play", transportState.isPlaying ? 1 : 0))
+    juce::Array<OSCDestination> destinations;
+
     {
-        DBG("Failed to send /play OSC message. Attempting to reconnect...");
-        if (!oscSender.connect("127.0.0.1", 8000))
-        {
-            DBG("Reconnection failed.");
-            return;
-        }
+        const juce::ScopedLock sl(destinationsLock);
+        destinations = oscDestinations;
     }
 
-    // Send tempo and position after reconnecting
-    if (!oscSender.send("/tempo", static_cast<float>(transportState.bpm)))
+    const bool allAccepted = oscStream.setDestinations(destinations);
+    transportEngine->notifyDestinationsChanged();
+
+    if (!allAccepted)
+        DBG("Error: some OSC destinations were rejected: " + getOscDestinations().joinIntoString(", ") + "!");
+
+    setOscPort(!destinations.isEmpty() ? destinations.getFirst().port : 0); // Port shown in the editor
+    return allAccepted;
+}
+
+void TransportSenderV1AudioProcessor::setOscDestinations(const juce::StringArray& hostPorts)
+{
+    juce::Array<OSCDestination> destinations;
+
+    for (auto& entry : hostPorts)
     {
-        DBG("Failed to send /tempo OSC message");
+        auto d = OSCDestination::fromString(entry);
+
+        if (d.isValid())
+            destinations.add(d);
+        else
+            DBG("Ignoring invalid OSC destination: " + entry);
     }
 
-    if (!oscSender.send("/position", static_cast<float>(transportState.ppqPosition)))
     {
-        DBG("Failed to send /position OSC message");
+        const juce::ScopedLock sl(destinationsLock);
+        oscDestinations = destinations;
     }
+
+    connectOscSender();
 }
 
+juce::StringArray TransportSenderV1AudioProcessor::getOscDestinations() const
+{
+    juce::StringArray result;
+    const juce::ScopedLock sl(destinationsLock);
+
+    for (auto& d : oscDestinations)
+        result.add(d.toString());
+
+    return result;
+}
 
 
-void TransportSenderV1AudioProcessor::oscMessageReceived(const juce::OSCMessage& message)
+bool TransportSenderV1AudioProcessor::startTransportRecording(const juce::File& file)
 {
-    auto address = message.getAddressPattern().toString();
-    DBG("Received OSC: " + address);
+    auto target = file;
+
+    if (target == juce::File())
+        target = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                     .getChildFile("TransportSender")
+                     .getChildFile("transport-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S")
+                                   + "-" + juce::String(getOscStreamId()) + ".tslog");
+
+    if (!oscStream.startRecording(target))
+    {
+        DBG("Error: can't record transport to " + target.getFullPathName());
+        return false;
+    }
+
+    DBG("Recording transport to " + target.getFullPathName());
+    return true;
+}
+
 
+// `address` has this instance's prefix (if any) already removed by the engine
+void TransportSenderV1AudioProcessor::oscMessageReceived(const juce::String& address, const juce::OSCMessage& message, uint64_t arrivalNs)
+{
+    // No logging here: this is the shared receiver thread, and a DBG per
+    // message allocates and takes the logger's lock
     if (message.size() > 0)
     {
         if (address == "/tempo" && message[0].isFloat32())
         {
             slaveTransportState.bpm = message[0].getFloat32();
-            DBG("Updated Tempo: " + juce::String(slaveTransportState.bpm));
+            slavePhaseTracker.updateTempo(slaveTransportState.bpm, arrivalNs);
+        }
+        else if (address == "/position" && message[0].isFloat32()) // ppq from another TransportSender
+        {
+            const double ppq = message[0].getFloat32();
+            setSlaveBarBeat(slaveTransportState.context.getBarBeatAt(ppq));
+            slavePhaseTracker.update(slaveTransportState.isPlaying, slaveTransportState.bpm, ppq, arrivalNs);
         }
         else if (address == "/position" && message.size() >= 5) // ✅ Ensure at least 5 elements (int | int | int)
         {
@@ -291,34 +468,79 @@ void TransportSenderV1AudioProcessor::oscMessageReceived(const juce::OSCMessage&
             // ✅ Only update state if we extracted 3 integers
             if (valueIndex == 3)
             {
+                // Ableton sends bar | beat | sixteenth, repeating it until the next 16th.
+                // Only a change marks the start of a 16th, so repeats aren't fed to the tracker.
+                const bool changed = receivedValues[0] != slaveTransportState.bar || receivedValues[1] != slaveTransportState.beat
+                                     || receivedValues[2] != slaveTransportState.subBeat;
+
                 slaveTransportState.bar = receivedValues[0];
                 slaveTransportState.beat = receivedValues[1];
                 slaveTransportState.subBeat = receivedValues[2];
 
-                DBG("Updated Position: " + juce::String(slaveTransportState.bar) + " | "
-                    + juce::String(slaveTransportState.beat) + " | "
-                    + juce::String(slaveTransportState.subBeat));
+                if (changed)
+                {
+                    const double ppq = slaveTransportState.context.getPpqAt(slaveTransportState.bar, slaveTransportState.beat,
+                                                                            slaveTransportState.subBeat);
+                    slavePhaseTracker.update(slaveTransportState.isPlaying, slaveTransportState.bpm, ppq, arrivalNs);
+                }
             }
             else
             {
-                DBG("Error: /position message did not contain 3 valid integers!");
+                oscStream.getTelemetry().recordMalformedReceived();
             }
         }
         else if (address == "/play" && message[0].isInt32())
         {
             slaveTransportState.isPlaying = (message[0].getInt32() == 1);
-            DBG("Updated Play State: " + juce::String(slaveTransportState.isPlaying ? "true" : "false"));
+            slavePhaseTracker.updatePlayState(slaveTransportState.isPlaying, arrivalNs);
+        }
+        else if (address == "/timesig" && message.size() >= 2 && message[0].isInt32() && message[1].isInt32())
+        {
+            slaveTransportState.context.timeSigNumerator = juce::jmax(1, message[0].getInt32());
+            slaveTransportState.context.timeSigDenominator = juce::jmax(1, message[1].getInt32());
+        }
+        else if (address == "/loop" && message.size() >= 3 && message[0].isInt32() && message[1].isFloat32() && message[2].isFloat32())
+        {
+            slaveTransportState.context.isLooping = message[0].getInt32() != 0;
+            slaveTransportState.context.loopStartPpq = message[1].getFloat32();
+            slaveTransportState.context.loopEndPpq = message[2].getFloat32();
+        }
+        else if (address == "/bar" && message.size() >= 2 && message[0].isFloat32() && message[1].isInt32())
+        {
+            slaveTransportState.context.barStartPpq = message[0].getFloat32();
+            slaveTransportState.context.barCount = message[1].getInt32();
+        }
+        else if (address == "/framerate" && message.size() >= 2 && message[0].isFloat32() && message[1].isInt32())
+        {
+            slaveTransportState.context.frameRate = message[0].getFloat32();
+            slaveTransportState.context.isDropFrame = message[1].getInt32() != 0;
+        }
+        else if (address == "/record" && message[0].isInt32())
+        {
+            slaveTransportState.context.isRecording = message[0].getInt32() != 0;
         }
     }
 
+    // Make the new state visible to the UI and audio thread in one consistent piece
+    slaveSnapshot.publish({ slaveTransportState, slavePhaseTracker });
+
     // ✅ Ensure UI updates when position changes
+    markSlaveStateChanged();
+}
+
+// The editor picks this up on its next display frame, however many packets
+// arrive in between
+void TransportSenderV1AudioProcessor::markSlaveStateChanged()
+{
+    slaveStateChanged = true;
+
+   #if TRANSPORT_UI_LEGACY_ASYNC
     juce::MessageManager::callAsync([this]
     {
         if (auto* editor = dynamic_cast<TransportSenderV1AudioProcessorEditor*>(getActiveEditor()))
-        {
-            editor->updateTransportLabels();
-        }
+            editor->refreshTransportLabelsLegacy();
     });
+   #endif
 }
 
 
@@ -333,13 +555,57 @@ void TransportSenderV1AudioProcessor::oscMessageReceived(const juce::OSCMessage&
 
 
 
+// Decode a BinaryTransportPacket from another sender. Same thread and same
+// publication path as oscMessageReceived, without any address or type-tag parsing.
+void TransportSenderV1AudioProcessor::binaryPacketReceived(const char* data, int dataSize, uint64_t arrivalNs)
+{
+    BinaryTransportPacket packet;
+
+    if (dataSize <= 0 || !BinaryTransportPacket::decode(data, static_cast<size_t>(dataSize), packet))
+    {
+        oscStream.getTelemetry().recordMalformedReceived();
+        return;
+    }
+
+    if (binarySequenceResetPending.exchange(false))
+        binarySequenceFilter.reset();
+
+    // Drop anything that arrives out of order, unless the sender has restarted
+    if (!binarySequenceFilter.accept(packet.sequence, arrivalNs))
+        return;
+
+    const double ppq = packet.getPpqPosition();
+
+    if (packet.hasContext())
+        slaveTransportState.context = packet.context;
+
+    slaveTransportState.isPlaying = packet.isPlaying();
+    slaveTransportState.bpm = packet.tempo;
+    setSlaveBarBeat(slaveTransportState.context.getBarBeatAt(ppq));
+
+    slavePhaseTracker.update(packet.isPlaying(), packet.tempo, ppq, arrivalNs);
+
+    slaveSnapshot.publish({ slaveTransportState, slavePhaseTracker });
+    markSlaveStateChanged();
+}
+
+
+
+void TransportSenderV1AudioProcessor::setSlaveBarBeat(const TransportContext::BarBeat& position)
+{
+    slaveTransportState.bar = position.bar;
+    slaveTransportState.beat = position.beat;
+    slaveTransportState.subBeat = position.sixteenth;
+}
+
+
+
 //Set transport state from button - maybe move this to a different section of the code later (near whatever handles playstate data)
+// Message thread. transportState belongs to the audio thread (it's the seqlock's
+// single writer), so this only posts the request; processBlock applies it.
 void TransportSenderV1AudioProcessor::setPlayingState(bool isPlaying)
 {
-    if (isPlaying)
-        transportState.isPlaying = true;  // Set transport state to playing
-    else
-        transportState.isPlaying = false; // Set transport state to stopped
+    requestedPlayState.store(isPlaying ? playRequested : stopRequested, std::memory_order_release);
 }
 
 
@@ -356,9 +622,60 @@ juce::AudioProcessorEditor* TransportSenderV1AudioProcessor::createEditor()
     return new TransportSenderV1AudioProcessorEditor(*this);
 }
 
-void TransportSenderV1AudioProcessor::getStateInformation(juce::MemoryBlock& destData) {}
+void TransportSenderV1AudioProcessor::getStateInformation(juce::MemoryBlock& destData)
+{
+    juce::ValueTree state("TransportSenderState");
+    state.setProperty("destinations", getOscDestinations().joinIntoString(","), nullptr);
+    state.setProperty("addressPrefix", getOscAddressPrefix(), nullptr);
+    state.setProperty("midiClock", isMidiClockEnabled(), nullptr);
 
-void TransportSenderV1AudioProcessor::setStateInformation(const void* data, int sizeInBytes) {}
+    const auto multicast = getMulticastOptions();
+
+    if (!(multicast == MulticastOptions {}))
+    {
+        state.setProperty("multicastTtl", multicast.ttl, nullptr);
+        state.setProperty("multicastInterface", multicast.interfaceAddress, nullptr);
+        state.setProperty("multicastLoopback", multicast.loopback, nullptr);
+    }
+
+    if (getMulticastReceiveGroup().isNotEmpty())
+        state.setProperty("multicastGroup", getMulticastReceiveGroup(), nullptr);
+
+    if (auto xml = state.createXml())
+        copyXmlToBinary(*xml, destData);
+}
+
+void TransportSenderV1AudioProcessor::setStateInformation(const void* data, int sizeInBytes)
+{
+    if (auto xml = getXmlFromBinary(data, sizeInBytes))
+    {
+        auto state = juce::ValueTree::fromXml(*xml);
+        binarySequenceResetPending = true;
+
+        if (state.hasProperty("destinations"))
+            setOscDestinations(juce::StringArray::fromTokens(state["destinations"].toString(), ",", ""));
+
+        setOscAddressPrefix(state.getProperty("addressPrefix", "").toString());
+        setMidiClockEnabled(state.getProperty("midiClock", false));
+
+        // Only sessions that used multicast touch the process-wide settings
+        if (state.hasProperty("multicastTtl"))
+        {
+            MulticastOptions multicast;
+            multicast.ttl = state["multicastTtl"];
+            multicast.interfaceAddress = state.getProperty("multicastInterface", "").toString();
+            multicast.loopback = state.getProperty("multicastLoopback", true);
+
+            if (!(multicast == getMulticastOptions()))
+                setMulticastOptions(multicast);
+        }
+
+        const auto group = state.getProperty("multicastGroup", "").toString();
+
+        if (group.isNotEmpty())
+            setMulticastReceiveGroup(group, state.getProperty("multicastInterface", "").toString());
+    }
+}
 
 #ifndef JucePlugin_PreferredChannelConfigurations
 bool TransportSenderV1AudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
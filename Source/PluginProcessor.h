@@ -3,10 +3,21 @@
 #include <JuceHeader.h>
 #include <juce_osc/juce_osc.h>
 #include <juce_audio_processors/juce_audio_processors.h>
-#include "OSCMessageSenderThread.h"
+#include "TransportEngine.h"
+#include "TransportPhaseTracker.h"
+#include "MidiClockGenerator.h"
+#include "SeqLockSnapshot.h"
+#include "TransportRateController.h"
 
+// Set to 1 to bring back the old incoming-OSC UI path, a callAsync per packet that
+// posts another one, in place of the per-frame refresh. Only for measuring the two
+// against each other with the editor's "UI ms/s" figure.
+#ifndef TRANSPORT_UI_LEGACY_ASYNC
+ #define TRANSPORT_UI_LEGACY_ASYNC 0
+#endif
 
-class TransportSenderV1AudioProcessor :public juce::AudioProcessor, public juce::OSCReceiver, public juce::OSCReceiver::ListenerWithOSCAddress<juce::OSCReceiver::MessageLoopCallback>
+
+class TransportSenderV1AudioProcessor :public juce::AudioProcessor, public TransportStream::Listener
     
 {
 public:
@@ -14,12 +25,8 @@ public:
     TransportSenderV1AudioProcessor();
     ~TransportSenderV1AudioProcessor() override;
     
-    //new:
-    double lastOscSendTime = 0;
-    const double oscSendIntervalMs = 33.0; // 30 fps equivalent
-    //endnew
-    
-    void oscMessageReceived(const juce::OSCMessage& message) override;
+    void oscMessageReceived(const juce::String& address, const juce::OSCMessage& message, uint64_t arrivalNs) override; // Runs on the shared OSC receiver thread
+    void binaryPacketReceived(const char* data, int dataSize, uint64_t arrivalNs) override; // Non-OSC datagrams on the same port
 
     
     // void updateOscMessageLabel();
@@ -27,16 +34,17 @@ public:
     
     void setPlayingState(bool isPlaying);
     
-    struct TransportState
+    // Time signature, loop, bar start, frame rate and record state come from
+    // TransportContext, filled from the host's PositionInfo each block
+    struct TransportState : TransportContext
        {
            bool isPlaying = false;
            double bpm = 120.0;
            double ppqPosition = 0.0;
-           int timeSigNumerator = 4;
-           int timeSigDenominator = 4;
        };
 
-       TransportState getTransportState() const { return transportState; }
+       // Safe from any thread: returns the state as of the last processed block
+       TransportState getTransportState() const { return transportSnapshot.read(); }
     //==============================================================================
     
     struct SlaveTransportState
@@ -48,18 +56,125 @@ public:
         int bar = 1;
         int beat = 1;
         int subBeat = 1;
+
+        // From another TransportSender's /timesig, /loop, /bar...; Ableton's
+        // /position carries no time signature, so that assumes 4/4 until told otherwise
+        TransportContext context;
     };
 
-    const SlaveTransportState& getSlaveTransportState() const { return slaveTransportState; }
+    // Any thread but the audio thread: reads the latest published slave state,
+    // retrying for as long as it races the receiver thread's publish
+    SlaveTransportState getSlaveTransportState() const { return slaveSnapshot.read().state; }
+
+    // For the audio thread: never waits, returning false and leaving `state`
+    // as it was if it raced a publish
+    bool tryGetSlaveTransportState(SlaveTransportState& state) const noexcept
+    {
+        PublishedSlaveState published;
+
+        if (!slaveSnapshot.tryRead(published))
+            return false;
+
+        state = published.state;
+        return true;
+    }
+
+    // True once after any incoming packet; the editor polls this once per frame
+    bool takeSlaveStateChanged() { return slaveStateChanged.exchange(false); }
+
+    // Continuously running slave position, phase-locked to the /position updates.
+    // Like getSlaveTransportState(), not for the audio thread.
+    double getSlavePpqPosition() const { return slaveSnapshot.read().tracker.getPpqAt(TransportClock::nowNs()); }
+
+    // Whether that position is locked to the incoming messages, and how well. Not
+    // for the audio thread either.
+    TransportPhaseTracker::Status getSlaveLockStatus() const { return slaveSnapshot.read().tracker.getStatus(TransportClock::nowNs()); }
     
     
     //==============================================================================
     // METHOD TO SET AND GET THE PORT #
-    juce::OSCSender& getOscSender() { return oscSender; } // Getter function to expose the oscSender
+    // Live state of this instance's links, kept up to date by the engine's connection manager
+    OSCDestinationSet::LinkState getOscLinkState() const { return getOscLinkSummary().state; }
+
+    // The same, with how many of the destinations are up
+    OSCDestinationSet::LinkSummary getOscLinkSummary() const
+    {
+        auto summary = oscStream.getLinkSummary();
+
+        if (!transportEngine->isSending())
+        {
+            summary.state = OSCDestinationSet::LinkState::down;
+            summary.numConnected = 0;
+        }
+
+        return summary;
+    }
+    bool isOscConnected() const
+    {
+        const auto state = getOscLinkState();
+        return state == OSCDestinationSet::LinkState::connected || state == OSCDestinationSet::LinkState::degraded;
+    }
+    uint64_t getNumDroppedOscMessages() const { return oscStream.getNumDroppedEvents(); } // Updates lost to a full queue
+    RealtimeSignal::WakeLatencyStats getSenderWakeLatency() const { return transportEngine->getWakeLatencyStats(); } // Audio thread -> sender hand-off latency (shared by all instances)
+    // Updates are change-driven; this is the keyframe rate sent during steady playback.
+    // Receivers using TransportExtrapolator stay smooth at 5-10 Hz.
+    void setOscSendRateHz(double hz);
+    double getOscSendRateHz() const { return 1.0 / rateControlSettings.read().keyframeIntervalSeconds; }
 
-    bool isOscConnected() const { return oscConnected; } // expose getter function
+    // Error/tempo thresholds and burst limit for change-driven updates (message thread only)
+    void setRateControlSettings(const TransportRateController::Settings& s) { rateControlSettings.publish(s); }
+    TransportRateController::Settings getRateControlSettings() const { return rateControlSettings.read(); }
+    void setUseOscBundles(bool shouldUseBundles) { oscStream.setUseBundles(shouldUseBundles); } // One timetagged datagram per update (default) vs. three messages
+    void setUseBinaryWireFormat(bool shouldUseBinary) { oscStream.setUseBinaryFormat(shouldUseBinary); } // BinaryTransportPacket instead of OSC, for high-rate links
     void setOscPort(int port) { oscPort = port; } // METHOD TO SET AND GET THE PORT
     int getOscPort() const { return oscPort; } // METHOD TO SET AND GET THE PORT
+
+    // 24 PPQN MIDI clock with Start/Stop/Continue/SPP on the plugin's MIDI output.
+    // Off by default, so a host routing our MIDI output isn't clocked unasked.
+    // Saved with the session. Turning it off while playing sends Stop.
+    void setMidiClockEnabled(bool shouldSend) { midiClockEnabled = shouldSend; }
+    bool isMidiClockEnabled() const { return midiClockEnabled; }
+
+    // Every update is encoded once and sent to each of these ("host:port" entries).
+    // "host:port sync" marks another TransportSender to keep a clock offset to.
+    void setOscDestinations(const juce::StringArray& hostPorts);
+    juce::StringArray getOscDestinations() const;
+    juce::Array<OSCDestinationSet::Stats> getOscDestinationStats() const { return oscStream.getDestinationStats(); }
+
+    // A multicast group ("239.255.0.1:8000") works as a destination: one send reaches
+    // every receiver that joined it. TTL, interface and loopback belong to the
+    // process's one send socket, so they apply to every instance. Both setters
+    // are POSIX only and return false on Windows.
+    bool setMulticastOptions(const MulticastOptions& options) { return transportEngine->setMulticastOptions(options); }
+    MulticastOptions getMulticastOptions() const { return transportEngine->getMulticastOptions(); }
+
+    // Also receive transport sent to this group on port 8002; empty leaves it.
+    // Process-wide too: the last instance to set it wins.
+    bool setMulticastReceiveGroup(const juce::String& group, const juce::String& interfaceAddress = {})
+    {
+        return transportEngine->joinMulticastGroup(group, interfaceAddress);
+    }
+    juce::String getMulticastReceiveGroup() const { return transportEngine->getMulticastGroup(); }
+
+    // Send pipeline telemetry, refreshed once a second by the sender thread; also
+    // sent to the destinations as /stats once turned on
+    TransportTelemetry::Report getTelemetryReport() const { return oscStream.getTelemetry().getReport(); }
+    uint64_t getTelemetryReportVersion() const { return oscStream.getTelemetry().getReportVersion(); }
+    void setPublishOscStats(bool shouldPublish) { oscStream.setPublishStats(shouldPublish); }
+
+    // Sent in front of every outgoing address ("/deck2/play") and used to pick out
+    // incoming messages meant for this instance. Empty by default.
+    void setOscAddressPrefix(const juce::String& prefix) { oscStream.setAddressPrefix(prefix); }
+    juce::String getOscAddressPrefix() const { return oscStream.getAddressPrefix(); }
+    int getOscStreamId() const { return oscStream.getStreamId(); } // Unique among the instances in this process
+
+    // Records everything this instance sends to a TransportLog file, for replaying
+    // to receivers later (Tools/TransportLogReplay.cpp). With no file given, a
+    // timestamped .tslog goes in Documents/TransportSender. Message thread only.
+    bool startTransportRecording(const juce::File& file = {});
+    void stopTransportRecording() { oscStream.stopRecording(); }
+    bool isRecordingTransport() const { return oscStream.isRecording(); }
+    uint64_t getNumRecordedUpdates() const { return oscStream.getNumRecordedUpdates(); }
     
     juce::String getLastOscMessage() const
     {
@@ -107,38 +222,78 @@ public:
 
 private:
     
-    // Slave Transport State
+    // Slave Transport State. The working copies belong to the OSC receiver
+    // thread; everyone else reads the published snapshot.
     SlaveTransportState slaveTransportState;
+    TransportPhaseTracker slavePhaseTracker;
+
+    struct PublishedSlaveState
+    {
+        SlaveTransportState state;
+        TransportPhaseTracker tracker;
+    };
+
+    SeqLockSnapshot<PublishedSlaveState> slaveSnapshot;
+    void setSlaveBarBeat(const TransportContext::BarBeat& position); // Receiver thread
+    BinarySequenceFilter binarySequenceFilter; // Receiver thread
+    std::atomic<bool> binarySequenceResetPending { false }; // Any thread asks, the receiver thread resets
+    std::atomic<bool> slaveStateChanged { true };
+    void markSlaveStateChanged(); // Receiver thread
     
     juce::String lastReceivedOSCMessage; // Stores the latest OSC message
    //     void updateOscMessageLabel(); // Moved this to public
     
     int oscPort = 0; // Store the connected OSC port #
-    bool oscConnected = false; // Tracks whether OSC is connected
    
     
-    void sendOSCMessages();
-    
-    juce::OSCSender oscSender;
-    juce::OSCReceiver oscReceiver;  // Listens for transport updates from Ableton
+    bool connectOscSender(); // Points this instance's stream at oscDestinations; never blocks
+
+    juce::CriticalSection destinationsLock;
+    juce::Array<OSCDestination> oscDestinations { OSCDestination { "127.0.0.1", 8000 } };
     
 
     
-    TransportState transportState;
+    TransportState transportState; // Audio thread's working copy
+    SeqLockSnapshot<TransportState> transportSnapshot; // Published each block for the editor and other readers
 
     // void updateTransportState();
 
-    //edits: variables for: accumalating sample, threshold
-    double sampleCounter = 0.0;
-    double samplesPerMessage = 0.0;
+    // Change-driven send scheduling, replacing the old fixed 30 Hz sample counter
+    TransportRateController rateController;
+    SeqLockSnapshot<TransportRateController::Settings> rateControlSettings;
+    double processedSeconds = 0.0; // Continuous clock the rate controller schedules against
+    double currentSampleRate = 44100.0;
+
+    // Timing of the block currently being processed, used to stamp snapshots
+    uint64_t blockHostTimeNs = 0; // TransportClock::nowNs() domain
+    TransportClock::HostClockMapper hostClock; // Audio thread only
+    int64_t blockTimeInSamples = 0;
+    TransportContext lastPublishedContext; // Context changes are published straight away, like tempo
+
+    // setPlayingState() requests, applied at the top of the next processBlock
+    enum PlayRequest { noPlayRequest, playRequested, stopRequested };
+    std::atomic<int> requestedPlayState { noPlayRequest };
+
+    MidiClockGenerator midiClock; // Audio thread only
+    juce::MidiBuffer midiClockEvents; // Reserved in prepareToPlay, so the clock never grows it on the audio thread
+    int midiClockBlockSize = 512;     // The block size it was reserved for; longer blocks are clocked in pieces
+    std::atomic<bool> midiClockEnabled { false };
+
+    uint64_t nextSnapshotSequence = 1; // Audio thread only; never reset, so the sender's ordering survives stop and prepareToPlay
+    OSCTransportMessage makeTransportSnapshot(int sampleOffset);
+    static void readTransportContext(const juce::AudioPlayHead::PositionInfo& posInfo, TransportContext& context);
+    TransportRateController::State getRateControlState(int sampleOffset) const;
 
     //new:
-    // For the message queue and its synchronization:
-    std::queue<OSCTransportMessage> oscMessageQueue;
-    juce::CriticalSection oscQueueLock;
+    // One receive socket, sender thread and send socket for every instance in
+    // the process; this instance only owns its stream.
+    juce::SharedResourcePointer<TransportEngine> transportEngine;
 
-    // Pointer for the OSC sender thread:
-    std::unique_ptr<OSCMessageSenderThread> oscThread;
+    // Lock-free hand-off to the shared sender thread. Periodic updates only
+    // replace the stream's latest value; a play/stop change that doesn't fit
+    // in its queue is held here and retried on the next block so it can never be lost.
+    TransportStream oscStream { *this };
+    bool playStateChangePending = false;
 
     
     //==============================================================================
@@ -0,0 +1,346 @@
+#include "RealtimeSafety.h"
+
+#if TRANSPORT_REALTIME_CHECKS
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#if defined(__linux__) || defined(__APPLE__)
+ #define TRANSPORT_REALTIME_INTERPOSE 1
+ #include <dlfcn.h>
+ #include <execinfo.h>
+ #include <poll.h>
+ #include <pthread.h>
+ #include <semaphore.h>
+ #include <sys/socket.h>
+ #include <time.h>
+ #include <unistd.h>
+#else
+ // Allocation checks only: no lock or blocking-call hooks, and no backtraces
+ #define TRANSPORT_REALTIME_INTERPOSE 0
+ #if defined(_WIN32)
+  #include <malloc.h>
+ #endif
+#endif
+
+// record() and check() must keep their own frames, as printNewViolations() skips them
+#if defined(_MSC_VER)
+ #define TRANSPORT_REALTIME_NOINLINE __declspec(noinline)
+#elif defined(__GNUC__)
+ #define TRANSPORT_REALTIME_NOINLINE __attribute__((noinline))
+#else
+ #define TRANSPORT_REALTIME_NOINLINE
+#endif
+
+namespace RealtimeSafety
+{
+namespace
+{
+    static constexpr int maxFrames = 12;
+    static constexpr int hookFrames = 3;        // record(), check() and the hook itself
+    static constexpr int maxRecorded = 64;
+
+    struct Violation
+    {
+        ViolationKind kind;
+        const char* function;
+        const char* scope;
+        void* frames[maxFrames];
+        int numFrames;
+    };
+
+    // Plain thread_locals with no constructor, so reading one never allocates
+    // or registers a destructor
+    thread_local int audioDepth = 0;
+    thread_local int allowDepth = 0;
+    thread_local bool isInHook = false;
+    thread_local const char* currentScope = nullptr;
+
+    Violation recorded[maxRecorded];
+    std::atomic<bool> isSlotReady[maxRecorded] {};
+    std::atomic<int> numClaimed { 0 };
+    std::atomic<uint64_t> numViolations { 0 };
+    std::atomic<uint64_t> numViolationsOfKind[4] {};
+    int numPrinted = 0; // Under printLock
+    std::mutex printLock;
+
+    const bool isFatal = [] { const char* v = std::getenv("TRANSPORT_REALTIME_CHECKS_FATAL"); return v != nullptr && *v != '0'; }();
+
+   #if TRANSPORT_REALTIME_INTERPOSE
+    // backtrace() loads its unwinder on first use; do that now, not in a hook
+    const int unwinderLoaded = [] { void* frame; return backtrace(&frame, 1); }();
+   #endif
+
+    const char* getKindName(ViolationKind kind) noexcept
+    {
+        switch (kind)
+        {
+            case ViolationKind::allocation:     return "allocation";
+            case ViolationKind::deallocation:   return "deallocation";
+            case ViolationKind::lock:           return "lock";
+            case ViolationKind::blockingCall:   return "blocking call";
+        }
+
+        return "";
+    }
+
+    bool isSameCallSite(const Violation& a, const Violation& b) noexcept
+    {
+        return a.kind == b.kind && a.numFrames == b.numFrames
+            && std::memcmp(a.frames, b.frames, sizeof(void*) * (size_t) a.numFrames) == 0;
+    }
+
+    TRANSPORT_REALTIME_NOINLINE void record(ViolationKind kind, const char* function) noexcept
+    {
+        numViolations.fetch_add(1, std::memory_order_relaxed);
+        numViolationsOfKind[(int) kind].fetch_add(1, std::memory_order_relaxed);
+
+        Violation v {};
+        v.kind = kind;
+        v.function = function;
+        v.scope = currentScope;
+
+       #if TRANSPORT_REALTIME_INTERPOSE
+        v.numFrames = backtrace(v.frames, maxFrames);
+       #endif
+
+        if (isFatal)
+        {
+            std::fprintf(stderr, "Realtime violation: %s (%s) in %s\n", getKindName(kind), function, v.scope);
+           #if TRANSPORT_REALTIME_INTERPOSE
+            backtrace_symbols_fd(v.frames, v.numFrames, STDERR_FILENO); // Doesn't allocate
+           #endif
+            std::abort();
+        }
+
+        // Once per call site; a block that allocates would otherwise fill the table in a few ms
+        const int numReady = std::min(numClaimed.load(std::memory_order_acquire), maxRecorded);
+
+        for (int i = 0; i < numReady; ++i)
+            if (isSlotReady[i].load(std::memory_order_acquire) && isSameCallSite(recorded[i], v))
+                return;
+
+        const int slot = numClaimed.fetch_add(1, std::memory_order_relaxed);
+
+        if (slot >= maxRecorded)
+            return;
+
+        recorded[slot] = v;
+        isSlotReady[slot].store(true, std::memory_order_release);
+    }
+
+    TRANSPORT_REALTIME_NOINLINE void check(ViolationKind kind, const char* function) noexcept
+    {
+        if (audioDepth == 0 || allowDepth > 0 || isInHook)
+            return;
+
+        isInHook = true; // backtrace() and friends may land back in a hook
+        record(kind, function);
+        isInHook = false;
+    }
+}
+
+//==============================================================================
+ScopedAudioThread::ScopedAudioThread(const char* scopeName) noexcept
+    : previousScope(currentScope)
+{
+    currentScope = scopeName;
+    ++audioDepth;
+}
+
+ScopedAudioThread::~ScopedAudioThread() noexcept
+{
+    --audioDepth;
+    currentScope = previousScope;
+}
+
+ScopedAllow::ScopedAllow() noexcept     { ++allowDepth; }
+ScopedAllow::~ScopedAllow() noexcept    { --allowDepth; }
+
+uint64_t getNumViolations() noexcept                        { return numViolations.load(std::memory_order_relaxed); }
+uint64_t getNumViolations(ViolationKind kind) noexcept      { return numViolationsOfKind[(int) kind].load(std::memory_order_relaxed); }
+
+void printNewViolations()
+{
+    const std::lock_guard<std::mutex> sl(printLock);
+    const int numReady = std::min(numClaimed.load(std::memory_order_acquire), maxRecorded);
+
+    for (; numPrinted < numReady && isSlotReady[numPrinted].load(std::memory_order_acquire); ++numPrinted)
+    {
+        const auto& v = recorded[numPrinted];
+        std::fprintf(stderr, "Realtime violation: %s (%s) in %s\n", getKindName(v.kind), v.function, v.scope);
+
+       #if TRANSPORT_REALTIME_INTERPOSE
+        if (v.numFrames > hookFrames)
+            backtrace_symbols_fd(v.frames + hookFrames, v.numFrames - hookFrames, STDERR_FILENO);
+       #endif
+    }
+
+    if (numClaimed.load(std::memory_order_relaxed) > maxRecorded && numPrinted == maxRecorded)
+        std::fprintf(stderr, "Realtime violation table full; further call sites not recorded\n");
+}
+}
+
+//==============================================================================
+// The plugin's allocator. Windows has no posix_memalign, and memory from
+// _aligned_malloc must go back through _aligned_free.
+
+#if defined(_WIN32)
+ #define TRANSPORT_REALTIME_ALIGNED_MALLOC 1
+#else
+ #define TRANSPORT_REALTIME_ALIGNED_MALLOC 0
+#endif
+
+namespace
+{
+    void* allocate(std::size_t size)
+    {
+        RealtimeSafety::check(RealtimeSafety::ViolationKind::allocation, "operator new");
+        return std::malloc(size != 0 ? size : 1);
+    }
+
+    void* allocateAligned(std::size_t size, std::align_val_t alignment)
+    {
+        RealtimeSafety::check(RealtimeSafety::ViolationKind::allocation, "operator new");
+
+       #if TRANSPORT_REALTIME_ALIGNED_MALLOC
+        return _aligned_malloc(size != 0 ? size : 1, (std::size_t) alignment);
+       #else
+        void* p = nullptr;
+        return posix_memalign(&p, std::max((std::size_t) alignment, sizeof(void*)), size != 0 ? size : 1) == 0 ? p : nullptr;
+       #endif
+    }
+
+    void release(void* p) noexcept
+    {
+        if (p == nullptr)
+            return;
+
+        RealtimeSafety::check(RealtimeSafety::ViolationKind::deallocation, "operator delete");
+        std::free(p);
+    }
+
+    void releaseAligned(void* p) noexcept
+    {
+        if (p == nullptr)
+            return;
+
+        RealtimeSafety::check(RealtimeSafety::ViolationKind::deallocation, "operator delete");
+
+       #if TRANSPORT_REALTIME_ALIGNED_MALLOC
+        _aligned_free(p);
+       #else
+        std::free(p);
+       #endif
+    }
+
+    void* allocateOrThrow(void* p)
+    {
+        if (p == nullptr)
+            throw std::bad_alloc();
+
+        return p;
+    }
+}
+
+void* operator new(std::size_t size)                                    { return allocateOrThrow(allocate(size)); }
+void* operator new[](std::size_t size)                                  { return allocateOrThrow(allocate(size)); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept    { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new(std::size_t size, std::align_val_t a)                { return allocateOrThrow(allocateAligned(size, a)); }
+void* operator new[](std::size_t size, std::align_val_t a)              { return allocateOrThrow(allocateAligned(size, a)); }
+void* operator new(std::size_t size, std::align_val_t a, const std::nothrow_t&) noexcept     { return allocateAligned(size, a); }
+void* operator new[](std::size_t size, std::align_val_t a, const std::nothrow_t&) noexcept   { return allocateAligned(size, a); }
+
+void operator delete(void* p) noexcept                                  { release(p); }
+void operator delete[](void* p) noexcept                                { release(p); }
+void operator delete(void* p, std::size_t) noexcept                     { release(p); }
+void operator delete[](void* p, std::size_t) noexcept                   { release(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept           { release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept         { release(p); }
+void operator delete(void* p, std::align_val_t) noexcept                { releaseAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept              { releaseAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept   { releaseAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept    { releaseAligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { releaseAligned(p); }
+
+//==============================================================================
+// Locks and blocking calls. Each hook checks, then forwards to the next
+// definition (libc's), looked up on first use. The cache is a constant-
+// initialised atomic, so there is no static guard that could itself lock.
+//
+// macOS bundles and Windows DLLs bind their own calls to these, and to the
+// allocator above, at link time. A Linux plugin must be linked with
+// -Wl,-Bsymbolic-functions, or its calls resolve to the host's libc and
+// libstdc++ first and the checks never run.
+//
+// Linux and macOS only: dlsym (RTLD_NEXT) has no Windows equivalent, so there
+// only the allocator is checked and these hooks don't exist.
+
+#if TRANSPORT_REALTIME_INTERPOSE
+
+namespace
+{
+    template <typename Function>
+    Function findNext(std::atomic<void*>& cache, const char* name) noexcept
+    {
+        void* f = cache.load(std::memory_order_relaxed);
+
+        if (f == nullptr)
+        {
+            f = dlsym(RTLD_NEXT, name);
+
+            // Nothing after us to forward to, e.g. a static libc: calling through
+            // null would crash somewhere far less obvious
+            if (f == nullptr)
+            {
+                std::fprintf(stderr, "RealtimeSafety: no next definition of %s to forward to (static libc?)\n", name);
+                std::abort();
+            }
+
+            cache.store(f, std::memory_order_relaxed);
+        }
+
+        return reinterpret_cast<Function>(f);
+    }
+}
+
+#define TRANSPORT_REALTIME_HOOK(kind, result, name, parameters, arguments) \
+    extern "C" result name parameters \
+    { \
+        static std::atomic<void*> next { nullptr }; \
+        RealtimeSafety::check(RealtimeSafety::ViolationKind::kind, #name); \
+        return findNext<result (*) parameters>(next, #name) arguments; \
+    }
+
+TRANSPORT_REALTIME_HOOK(lock, int, pthread_mutex_lock,      (pthread_mutex_t* m),   (m))
+TRANSPORT_REALTIME_HOOK(lock, int, pthread_rwlock_rdlock,   (pthread_rwlock_t* l),  (l))
+TRANSPORT_REALTIME_HOOK(lock, int, pthread_rwlock_wrlock,   (pthread_rwlock_t* l),  (l))
+TRANSPORT_REALTIME_HOOK(lock, int, pthread_cond_wait,       (pthread_cond_t* c, pthread_mutex_t* m), (c, m))
+TRANSPORT_REALTIME_HOOK(lock, int, pthread_cond_timedwait, (pthread_cond_t* c, pthread_mutex_t* m, const struct timespec* t), (c, m, t))
+TRANSPORT_REALTIME_HOOK(lock, int, pthread_join,            (pthread_t t, void** r), (t, r))
+TRANSPORT_REALTIME_HOOK(lock, int, sem_wait,                (sem_t* s),             (s))
+
+TRANSPORT_REALTIME_HOOK(blockingCall, ssize_t, read,        (int fd, void* b, size_t n),        (fd, b, n))
+TRANSPORT_REALTIME_HOOK(blockingCall, ssize_t, write,       (int fd, const void* b, size_t n),  (fd, b, n))
+TRANSPORT_REALTIME_HOOK(blockingCall, ssize_t, send,        (int fd, const void* b, size_t n, int f), (fd, b, n, f))
+TRANSPORT_REALTIME_HOOK(blockingCall, ssize_t, sendto,      (int fd, const void* b, size_t n, int f, const struct sockaddr* a, socklen_t l), (fd, b, n, f, a, l))
+TRANSPORT_REALTIME_HOOK(blockingCall, ssize_t, recv,        (int fd, void* b, size_t n, int f), (fd, b, n, f))
+TRANSPORT_REALTIME_HOOK(blockingCall, ssize_t, recvfrom,    (int fd, void* b, size_t n, int f, struct sockaddr* a, socklen_t* l), (fd, b, n, f, a, l))
+TRANSPORT_REALTIME_HOOK(blockingCall, int, poll,            (struct pollfd* p, nfds_t n, int t), (p, n, t))
+TRANSPORT_REALTIME_HOOK(blockingCall, int, fsync,           (int fd),               (fd))
+TRANSPORT_REALTIME_HOOK(blockingCall, int, usleep,          (useconds_t us),        (us))
+TRANSPORT_REALTIME_HOOK(blockingCall, int, nanosleep,       (const struct timespec* t, struct timespec* r), (t, r))
+TRANSPORT_REALTIME_HOOK(blockingCall, unsigned int, sleep, (unsigned int s),        (s))
+TRANSPORT_REALTIME_HOOK(blockingCall, FILE*, fopen,         (const char* p, const char* m), (p, m))
+
+#undef TRANSPORT_REALTIME_HOOK
+
+#endif
+#endif
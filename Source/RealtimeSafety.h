@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+
+// Debug/test builds only: add TRANSPORT_REALTIME_CHECKS=1 to the configuration's
+// preprocessor definitions. Off, everything here compiles to nothing.
+#ifndef TRANSPORT_REALTIME_CHECKS
+ #define TRANSPORT_REALTIME_CHECKS 0
+#endif
+
+/**
+ * @namespace RealtimeSafety
+ * @brief Catches audio-thread code doing things it must not: allocating or
+ *        freeing memory, taking a lock, or making a call that can block.
+ *
+ *        With TRANSPORT_REALTIME_CHECKS on, RealtimeSafety.cpp replaces the
+ *        plugin's operator new and delete and, on Linux and macOS, interposes
+ *        pthread_mutex_lock, the rwlock and condition-variable waits, sem_wait
+ *        and the blocking I/O and sleep calls. They see every call made from
+ *        the plugin's own code, JUCE included; on Linux that needs the plugin
+ *        linked with -Wl,-Bsymbolic-functions. malloc and calls made inside
+ *        other libraries are not covered. try-locks are allowed.
+ *
+ *        A hook checks a thread-local flag that ScopedAudioThread sets for the
+ *        length of processBlock; anywhere else it costs one TLS read. Each
+ *        violation is recorded with its backtrace, once per call site, and
+ *        printNewViolations() writes them to stderr, symbolised.
+ *
+ *        With TRANSPORT_REALTIME_CHECKS_FATAL=1 in the environment, the first
+ *        violation prints its backtrace and aborts, so any run that drives
+ *        processBlock (pluginval, a host smoke test) fails on a regression.
+ */
+namespace RealtimeSafety
+{
+    enum class ViolationKind
+    {
+        allocation,
+        deallocation,
+        lock,
+        blockingCall
+    };
+
+   #if TRANSPORT_REALTIME_CHECKS
+    // Marks the calling thread as realtime until destroyed. Nests.
+    class ScopedAudioThread
+    {
+    public:
+        explicit ScopedAudioThread(const char* scopeName) noexcept;
+        ~ScopedAudioThread() noexcept;
+
+    private:
+        const char* previousScope;
+        ScopedAudioThread(const ScopedAudioThread&) = delete;
+        ScopedAudioThread& operator=(const ScopedAudioThread&) = delete;
+    };
+
+    // Lets a deliberate exception through, e.g. a debug-only log line
+    class ScopedAllow
+    {
+    public:
+        ScopedAllow() noexcept;
+        ~ScopedAllow() noexcept;
+
+    private:
+        ScopedAllow(const ScopedAllow&) = delete;
+        ScopedAllow& operator=(const ScopedAllow&) = delete;
+    };
+
+    // Every violation, including repeats at a call site already reported
+    uint64_t getNumViolations() noexcept;
+    uint64_t getNumViolations(ViolationKind kind) noexcept;
+
+    // Writes violations not printed before to stderr. Any thread but the audio thread.
+    void printNewViolations();
+   #else
+    class ScopedAudioThread
+    {
+    public:
+        explicit ScopedAudioThread(const char*) noexcept {}
+    };
+
+    class ScopedAllow
+    {
+    public:
+        ScopedAllow() noexcept {}
+    };
+
+    inline uint64_t getNumViolations() noexcept                 { return 0; }
+    inline uint64_t getNumViolations(ViolationKind) noexcept    { return 0; }
+    inline void printNewViolations()                            {}
+   #endif
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include "TransportClock.h"
+
+#if defined(__APPLE__)
+ #include <dispatch/dispatch.h>
+#elif defined(_WIN32)
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#else
+ #include <cerrno>
+ #include <ctime>
+ #include <semaphore.h>
+#endif
+
+/**
+ * @class RealtimeSignal
+ * @brief Wakes a single parked consumer thread from a realtime producer.
+ *
+ *        signal() is a single atomic exchange unless the consumer is actually
+ *        parked, in which case it also posts an OS semaphore (dispatch
+ *        semaphore, POSIX sem_post or ReleaseSemaphore). None of those take a
+ *        user-space lock, so it is safe to call from processBlock.
+ *
+ *        wait() may occasionally return early with nothing to do (a post that
+ *        raced with a timeout leaves one spare token behind); callers loop and
+ *        re-check their queue anyway, so that is harmless.
+ *
+ *        The time between a post and the consumer running again is measured,
+ *        so the wake latency of the hand-off can be reported.
+ */
+class RealtimeSignal
+{
+public:
+    struct WakeLatencyStats
+    {
+        uint64_t numWakes = 0;
+        uint64_t averageNs = 0;
+        uint64_t maxNs = 0;
+    };
+
+    RealtimeSignal()
+    {
+       #if defined(__APPLE__)
+        semaphore = dispatch_semaphore_create(0);
+       #elif defined(_WIN32)
+        semaphore = CreateSemaphoreW(nullptr, 0, 0x7fffffff, nullptr);
+       #else
+        sem_init(&semaphore, 0, 0);
+       #endif
+    }
+
+    ~RealtimeSignal()
+    {
+       #if defined(__APPLE__)
+        dispatch_release(semaphore);
+       #elif defined(_WIN32)
+        CloseHandle(semaphore);
+       #else
+        sem_destroy(&semaphore);
+       #endif
+    }
+
+    // Producer side: realtime-safe, never blocks.
+    void signal() noexcept
+    {
+        if (state.exchange(signalled, std::memory_order_acq_rel) == parked)
+        {
+            postTimeNs.store(TransportClock::nowNs(), std::memory_order_relaxed);
+            post();
+        }
+    }
+
+    // Consumer side: returns true if there may be work, false on timeout.
+    bool wait(int timeoutMs) noexcept
+    {
+        if (state.exchange(idle, std::memory_order_acq_rel) == signalled)
+            return true;
+
+        int expected = idle;
+        if (!state.compare_exchange_strong(expected, parked, std::memory_order_acq_rel))
+        {
+            state.store(idle, std::memory_order_release);
+            return true;
+        }
+
+        const bool woken = timedWait(timeoutMs);
+        const bool wasSignalled = state.exchange(idle, std::memory_order_acq_rel) == signalled;
+
+        // A wake without a matching signal is a leftover token; don't let its
+        // stale post time pollute the latency figures.
+        if (woken && wasSignalled)
+            recordWake(TransportClock::nowNs() - postTimeNs.load(std::memory_order_relaxed));
+
+        return woken || wasSignalled;
+    }
+
+    WakeLatencyStats getWakeLatencyStats() const noexcept
+    {
+        WakeLatencyStats stats;
+        stats.numWakes = numWakes.load(std::memory_order_relaxed);
+        stats.maxNs = maxLatencyNs.load(std::memory_order_relaxed);
+
+        if (stats.numWakes > 0)
+            stats.averageNs = totalLatencyNs.load(std::memory_order_relaxed) / stats.numWakes;
+
+        return stats;
+    }
+
+private:
+    enum : int { idle = 0, signalled = 1, parked = -1 };
+
+    void post() noexcept
+    {
+       #if defined(__APPLE__)
+        dispatch_semaphore_signal(semaphore);
+       #elif defined(_WIN32)
+        ReleaseSemaphore(semaphore, 1, nullptr);
+       #else
+        sem_post(&semaphore);
+       #endif
+    }
+
+    bool timedWait(int timeoutMs) noexcept
+    {
+       #if defined(__APPLE__)
+        return dispatch_semaphore_wait(semaphore, dispatch_time(DISPATCH_TIME_NOW, (int64_t) timeoutMs * NSEC_PER_MSEC)) == 0;
+       #elif defined(_WIN32)
+        return WaitForSingleObject(semaphore, (DWORD) timeoutMs) == WAIT_OBJECT_0;
+       #else
+        timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec  += timeoutMs / 1000;
+        deadline.tv_nsec += (long) (timeoutMs % 1000) * 1000000L;
+
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec  += 1;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        while (sem_timedwait(&semaphore, &deadline) != 0)
+            if (errno != EINTR)
+                return false;
+
+        return true;
+       #endif
+    }
+
+    void recordWake(uint64_t latencyNs) noexcept
+    {
+        // Only the consumer writes these, so plain load/store is enough
+        numWakes.store(numWakes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        totalLatencyNs.store(totalLatencyNs.load(std::memory_order_relaxed) + latencyNs, std::memory_order_relaxed);
+        maxLatencyNs.store(std::max(maxLatencyNs.load(std::memory_order_relaxed), latencyNs), std::memory_order_relaxed);
+    }
+
+    std::atomic<int> state { idle };
+    std::atomic<uint64_t> postTimeNs { 0 };
+
+    std::atomic<uint64_t> numWakes { 0 };
+    std::atomic<uint64_t> totalLatencyNs { 0 };
+    std::atomic<uint64_t> maxLatencyNs { 0 };
+
+   #if defined(__APPLE__)
+    dispatch_semaphore_t semaphore;
+   #elif defined(_WIN32)
+    HANDLE semaphore;
+   #else
+    sem_t semaphore;
+   #endif
+
+    RealtimeSignal(const RealtimeSignal&) = delete;
+    RealtimeSignal& operator=(const RealtimeSignal&) = delete;
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class SPSCRingBuffer
+ * @brief A bounded, preallocated single-producer/single-consumer ring buffer.
+ *
+ *        push() and pop() are wait-free: neither side ever takes a lock or
+ *        allocates, so the producer can safely be the audio thread. When the
+ *        ring is full push() refuses the new element and bumps a drop counter;
+ *        the caller decides whether to retry it later or let it go.
+ */
+template <typename ElementType, size_t Capacity>
+class SPSCRingBuffer
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "SPSCRingBuffer capacity must be a power of two");
+
+public:
+    SPSCRingBuffer() = default;
+
+    // Producer side only. Returns false (and counts a drop) if the ring is full.
+    bool push(const ElementType& element) noexcept
+    {
+        const auto write = writeIndex.load(std::memory_order_relaxed);
+        const auto read  = readIndex.load(std::memory_order_acquire);
+
+        if (write - read >= Capacity)
+        {
+            numDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        slots[write & mask] = element;
+        writeIndex.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side only. Returns false if the ring is empty.
+    bool pop(ElementType& element) noexcept
+    {
+        const auto read  = readIndex.load(std::memory_order_relaxed);
+        const auto write = writeIndex.load(std::memory_order_acquire);
+
+        if (read == write)
+            return false;
+
+        element = slots[read & mask];
+        readIndex.store(read + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called from a third thread, exact from either end.
+    size_t getNumReady() const noexcept
+    {
+        return static_cast<size_t>(writeIndex.load(std::memory_order_acquire)
+                                      - readIndex.load(std::memory_order_acquire));
+    }
+
+    bool isEmpty() const noexcept                  { return getNumReady() == 0; }
+    static constexpr size_t getCapacity() noexcept { return Capacity; }
+
+    uint64_t getNumDropped() const noexcept        { return numDropped.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t mask = Capacity - 1;
+
+    // Keep the two indices on separate cache lines so producer and consumer
+    // don't keep stealing the same line from each other.
+    alignas(64) std::atomic<size_t> writeIndex { 0 };
+    alignas(64) std::atomic<size_t> readIndex   { 0 };
+    alignas(64) std::atomic<uint64_t> numDropped { 0 };
+
+    std::array<ElementType, Capacity> slots {};
+};
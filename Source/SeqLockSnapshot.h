@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @class SeqLockSnapshot
+ * @brief Latest-value publication from one writer to any number of readers.
+ *
+ *        publish() is wait-free and never blocks on readers, so the audio
+ *        thread can call it every block. read() always returns a complete,
+ *        consistent copy of the most recently published value; if it races
+ *        with a publish it simply retries. tryRead() is the bounded version
+ *        for realtime readers, which keep their previous copy if it fails.
+ *        There is no queue, so a slow reader never builds up a backlog of
+ *        stale values - it just sees the newest one next time.
+ *
+ *        The payload is stored as relaxed atomic words, so concurrent access
+ *        is well defined as long as T is trivially copyable.
+ */
+template <typename T>
+class SeqLockSnapshot
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLockSnapshot needs a trivially copyable type");
+
+public:
+    SeqLockSnapshot()                        { publish(T {}); }
+    explicit SeqLockSnapshot(const T& init) { publish(init); }
+
+    // Single writer only.
+    void publish(const T& value) noexcept
+    {
+        Words words {};
+        std::memcpy(words.data(), &value, sizeof(T));
+
+        const auto seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < numWords; ++i)
+            storage[i].store(words[i], std::memory_order_relaxed);
+
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // Any thread but a realtime one: retries for as long as it races with a
+    // publish. `version` increases by one for every publish().
+    T read(uint64_t* version = nullptr) const noexcept
+    {
+        Words words;
+        uint64_t seq = 0;
+
+        while (!tryReadWords(words, seq))
+        {
+        }
+
+        if (version != nullptr)
+            *version = seq / 2;
+
+        return fromWords(words);
+    }
+
+    // For the audio thread: gives up after `maxAttempts` races with a publish,
+    // returning false and leaving `value` as it was. The writer only has a
+    // handful of stores to make, so in practice the first attempt succeeds.
+    bool tryRead(T& value, int maxAttempts = 4) const noexcept
+    {
+        Words words;
+        uint64_t seq = 0;
+
+        for (int attempt = 0; attempt < maxAttempts; ++attempt)
+        {
+            if (tryReadWords(words, seq))
+            {
+                value = fromWords(words);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    uint64_t getVersion() const noexcept     { return sequence.load(std::memory_order_acquire) / 2; }
+
+private:
+    static constexpr size_t numWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    using Words = std::array<uint64_t, numWords>;
+
+    // One attempt: false if a publish was in progress or overlapped the copy
+    bool tryReadWords(Words& words, uint64_t& seq) const noexcept
+    {
+        seq = sequence.load(std::memory_order_acquire);
+
+        if ((seq & 1) != 0)
+            return false; // Writer is mid-publish
+
+        for (size_t i = 0; i < numWords; ++i)
+            words[i] = storage[i].load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return sequence.load(std::memory_order_relaxed) == seq;
+    }
+
+    static T fromWords(const Words& words) noexcept
+    {
+        T value;
+        std::memcpy(&value, words.data(), sizeof(T));
+        return value;
+    }
+
+    alignas(64) std::atomic<uint64_t> sequence { 0 };
+    std::array<std::atomic<uint64_t>, numWords> storage {};
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+/**
+ * @namespace TransportClock
+ * @brief Monotonic nanosecond clock every transport timestamp is in, plus
+ *        helpers for mapping the host's own clock onto it and putting those
+ *        timestamps on the wire.
+ */
+namespace TransportClock
+{
+    inline uint64_t nowNs() noexcept
+    {
+        using namespace std::chrono;
+        return static_cast<uint64_t>(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+    }
+
+    // 32.32 fixed-point seconds, the layout of an OSC/NTP timetag, with no epoch applied.
+    inline uint64_t nsToFixedPoint(uint64_t ns) noexcept
+    {
+        const uint64_t seconds  = ns / 1000000000ull;
+        const uint64_t fraction = ((ns % 1000000000ull) << 32) / 1000000000ull;
+        return (seconds << 32) | fraction;
+    }
+
+    inline uint64_t fixedPointToNs(uint64_t fixedPoint) noexcept
+    {
+        const uint64_t seconds  = fixedPoint >> 32;
+        const uint64_t fraction = fixedPoint & 0xffffffffull;
+        return seconds * 1000000000ull + ((fraction * 1000000000ull) >> 32);
+    }
+
+    // What to add to nowNs() to get nanoseconds since the NTP epoch (1 Jan 1900).
+    // Read from the system clock once, the first time it's needed, so timetags keep
+    // nowNs()'s monotonic spacing and don't jump if the wall clock is stepped later.
+    inline uint64_t ntpEpochOffsetNs() noexcept
+    {
+        static const uint64_t offset = []
+        {
+            using namespace std::chrono;
+            constexpr uint64_t secondsFrom1900To1970 = 2208988800ull;
+            const auto unixNs = static_cast<uint64_t>(duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count());
+            return secondsFrom1900To1970 * 1000000000ull + unixNs - nowNs();
+        }();
+
+        return offset;
+    }
+
+    // An OSC/NTP timetag for a nowNs() timestamp, and back. Third-party receivers
+    // compare timetags to their own wall clock, so these are anchored at the NTP
+    // epoch via the system clock, accurate to however well this machine's clock is set.
+    inline uint64_t nsToTimeTag(uint64_t ns) noexcept
+    {
+        return nsToFixedPoint(ns + ntpEpochOffsetNs());
+    }
+
+    inline uint64_t timeTagToNs(uint64_t timeTag) noexcept
+    {
+        return fixedPointToNs(timeTag) - ntpEpochOffsetNs();
+    }
+
+    // OSC 1.0 has no 64-bit integer, so timestamps travel as two int32 words.
+    inline int32_t highWord(uint64_t value) noexcept { return static_cast<int32_t>(static_cast<uint32_t>(value >> 32)); }
+    inline int32_t lowWord(uint64_t value) noexcept  { return static_cast<int32_t>(static_cast<uint32_t>(value)); }
+
+    inline uint64_t fromWords(int32_t high, int32_t low) noexcept
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(high)) << 32) | static_cast<uint32_t>(low);
+    }
+
+    /**
+     * Moves the host's PositionInfo::getHostTimeNs() into the nowNs() domain.
+     * Hosts read that from whatever clock they like (mach_absolute_time(),
+     * QueryPerformanceCounter, their own engine clock), so the offset to nowNs()
+     * is measured once per block and smoothed over scheduling jitter. A jump
+     * bigger than resyncThresholdNs means the host's clock was reset or swapped,
+     * and re-anchors straight away. Audio thread only.
+     */
+    class HostClockMapper
+    {
+    public:
+        static constexpr int64_t resyncThresholdNs = 50000000; // 50 ms
+        static constexpr int smoothingShift = 6; // Each block moves the offset 1/64 of the way
+
+        // The block's start time in nowNs() terms: the host's time, mapped, when
+        // the host gives one, otherwise localNowNs as it stands.
+        uint64_t getBlockTimeNs(std::optional<uint64_t> hostTimeNs, uint64_t localNowNs) noexcept
+        {
+            if (!hostTimeNs.has_value())
+                return localNowNs;
+
+            const auto measured = static_cast<int64_t>(localNowNs - *hostTimeNs);
+
+            if (!hasOffset || measured - offsetNs > resyncThresholdNs || offsetNs - measured > resyncThresholdNs)
+            {
+                offsetNs = measured;
+                hasOffset = true;
+            }
+            else
+            {
+                offsetNs += (measured - offsetNs) / (int64_t { 1 } << smoothingShift);
+            }
+
+            return *hostTimeNs + static_cast<uint64_t>(offsetNs);
+        }
+
+        void reset() noexcept { hasOffset = false; }
+
+    private:
+        int64_t offsetNs = 0;
+        bool hasOffset = false;
+    };
+}
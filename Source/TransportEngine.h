@@ -0,0 +1,314 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <juce_osc/juce_osc.h>
+#include <algorithm>
+#include "ClockSyncResponder.h"
+#include "OSCConnectionManager.h"
+#include "OSCMessageSenderThread.h"
+#include "TransportStream.h"
+
+/**
+ * @class TransportEngine
+ * @brief The process-wide networking shared by every plugin instance: one
+ *        OSC receive socket on receivePort, one sender thread, one send socket,
+ *        one thread for destination lookups and one, on clockSyncPort, for
+ *        answering clock-sync pings. Hold it through juce::SharedResourcePointer<TransportEngine>;
+ *        it is created with the first instance and torn down with the last, so
+ *        thread and socket counts stay the same however many instances a
+ *        session loads.
+ *
+ *        Each instance registers a TransportStream. Outgoing updates are sent
+ *        per stream; incoming messages are routed by address prefix, and binary
+ *        packets by the sender's stream ID, to the stream with the same prefix
+ *        or ID. Anything no stream claims goes to every stream. Listeners are
+ *        called without streamsLock held, so a slow listener never holds up an
+ *        instance being added or removed.
+ *
+ *        Clock sync: pings go out from the receive socket to a destination's
+ *        clockSyncPort, so the /pong comes back to receivePort and goes to the
+ *        stream and destination named by its token, never to a listener (see
+ *        OSCDestinationSet::sendPings()). ClockSyncResponder answers other
+ *        TransportSenders' pings. The receive socket itself replies to nothing.
+ *
+ *        Multicast: a group address is an ordinary destination, and one send
+ *        reaches every member. TTL, interface and loopback belong to the shared
+ *        send socket (setMulticastOptions()). To receive a group's transport,
+ *        the receive socket joins it (joinMulticastGroup()); packets sent to the
+ *        group on receivePort then arrive alongside unicast ones.
+ */
+class TransportEngine : private juce::OSCReceiver::Listener<juce::OSCReceiver::RealtimeCallback>
+{
+public:
+    static constexpr int receivePort = 8002;
+    static constexpr int clockSyncPort = receivePort + 1;
+
+    TransportEngine()
+        : senderThread(receiveSocket, clockSyncPort)
+    {
+        // Our own socket rather than receiver.connect(), so it can join multicast groups
+        if (receiveSocket.bindToPort(receivePort) && receiver.connectToSocket(receiveSocket))
+        {
+            DBG("OSC Receiver connected on port " + juce::String(receivePort) + ".");
+            receiving = true;
+            receiver.addListener(this);
+
+            // Anything that isn't valid OSC lands here; that's how binary transport packets arrive
+            receiver.registerFormatErrorHandler([this](const char* data, int dataSize)
+            {
+                routePacket(data, dataSize);
+            });
+        }
+        else
+        {
+            DBG("Error: OSC Receiver failed to connect!");
+        }
+
+        senderThread.startThread();
+        connectionManager.startThread();
+        clockSyncResponder.start(clockSyncPort);
+    }
+
+    ~TransportEngine() override
+    {
+        receiver.removeListener(this);
+        receiver.disconnect();
+        clockSyncResponder.stop();
+        senderThread.stopSending(100); // Wakes the thread and waits up to 100 ms for it to stop
+
+        // A lookup can't be interrupted, so this may wait out a slow DNS server
+        connectionManager.signalThreadShouldExit();
+        connectionManager.notify();
+        connectionManager.stopThread(connectionManagerStopTimeoutMs);
+    }
+
+    // Message thread. The stream gets the lowest ID not already in use.
+    void addStream(TransportStream& stream)
+    {
+        {
+            const juce::ScopedLock sl(streamsLock);
+
+            int id = 1;
+            while (std::any_of(streams.begin(), streams.end(), [id](auto* s) { return s->getStreamId() == id; }))
+                ++id;
+
+            stream.setStreamId(id);
+            streams.addIfNotAlreadyThere(&stream);
+        }
+
+        senderThread.addStream(stream);
+        connectionManager.addStream(stream);
+        DBG("Transport stream " + juce::String(stream.getStreamId()) + " added, "
+            + juce::String(getNumStreams()) + " active");
+    }
+
+    // Once this returns, neither the sender nor the receiver will touch the stream again
+    void removeStream(TransportStream& stream)
+    {
+        senderThread.removeStream(stream);
+        connectionManager.removeStream(stream);
+
+        uint64_t lastDeliveryToStream = 0;
+
+        {
+            const juce::ScopedLock sl(streamsLock);
+            streams.removeFirstMatchingValue(&stream);
+            lastDeliveryToStream = deliveriesStarted;
+        }
+
+        // A delivery that picked the stream up before it was removed may still be running
+        while (deliveriesFinished.load(std::memory_order_acquire) < lastDeliveryToStream)
+            juce::Thread::sleep(1);
+    }
+
+    int getNumStreams() const
+    {
+        const juce::ScopedLock sl(streamsLock);
+        return streams.size();
+    }
+
+    // After a stream's destinations change, so they are looked up straight away
+    void notifyDestinationsChanged() { connectionManager.notifyDestinationsChanged(); }
+
+    // Realtime-safe; any instance's processBlock may call it
+    void notifyWorkAvailable() noexcept { senderThread.notifyWorkAvailable(); }
+
+    bool isReceiving() const { return receiving; }
+    bool isSending() const { return senderThread.isSocketOpen(); }
+    RealtimeSignal::WakeLatencyStats getWakeLatencyStats() const { return senderThread.getWakeLatencyStats(); }
+
+    // Process-wide, like the socket they apply to
+    bool setMulticastOptions(const MulticastOptions& options) { return senderThread.setMulticastOptions(options); }
+    MulticastOptions getMulticastOptions() const { return senderThread.getMulticastOptions(); }
+
+    // Message thread. Joins `group` on the given interface (empty for the OS's
+    // choice), leaving any group joined before; an empty group just leaves.
+    bool joinMulticastGroup(const juce::String& group, const juce::String& interfaceAddress = {})
+    {
+        if (group == joinedGroup && interfaceAddress == joinedInterface)
+            return group.isEmpty() || receiving;
+
+        if (joinedGroup.isNotEmpty())
+            OSCDestinationSet::setMulticastMembership(receiveSocket, joinedGroup, joinedInterface, false);
+
+        joinedGroup = {};
+        joinedInterface = {};
+
+        if (group.isEmpty())
+            return true;
+
+        if (!receiving || !OSCDestinationSet::setMulticastMembership(receiveSocket, group, interfaceAddress, true))
+        {
+            DBG("Error: couldn't join multicast group " + group + ".");
+            return false;
+        }
+
+        joinedGroup = group;
+        joinedInterface = interfaceAddress;
+        return true;
+    }
+
+    juce::String getMulticastGroup() const { return joinedGroup; }
+
+private:
+    void oscMessageReceived(const juce::OSCMessage& message) override
+    {
+        routeMessage(message, TransportClock::nowNs());
+    }
+
+    void oscBundleReceived(const juce::OSCBundle& bundle) override
+    {
+        routeBundle(bundle, TransportClock::nowNs());
+    }
+
+    void routeBundle(const juce::OSCBundle& bundle, uint64_t arrivalNs)
+    {
+        for (auto& element : bundle)
+        {
+            if (element.isMessage())
+                routeMessage(element.getMessage(), arrivalNs);
+            else if (element.isBundle())
+                routeBundle(element.getBundle(), arrivalNs);
+        }
+    }
+
+    // A prefixed address goes to the stream(s) with that prefix; anything else goes to all of them
+    void routeMessage(const juce::OSCMessage& message, uint64_t arrivalNs)
+    {
+        const auto address = message.getAddressPattern().toString();
+        juce::String localAddress;
+
+        {
+            const juce::ScopedLock sl(streamsLock);
+
+            if (address == "/pong")
+            {
+                pongReceived(message, arrivalNs);
+                return;
+            }
+
+            beginDelivery([&](const TransportStream& stream) { return stream.claimsAddress(address, localAddress); });
+        }
+
+        const auto& deliveredAddress = localAddress.isNotEmpty() ? localAddress : address;
+
+        for (auto* stream : deliveryTargets)
+            stream->getListener().oscMessageReceived(deliveredAddress, message, arrivalNs);
+
+        endDelivery();
+    }
+
+    // Called with streamsLock held
+    void pongReceived(const juce::OSCMessage& message, uint64_t arrivalNs)
+    {
+        if (message.size() < 7)
+            return;
+
+        for (int i = 0; i < 7; ++i)
+            if (!message[i].isInt32())
+                return;
+
+        const auto token = message[0].getInt32();
+        const auto streamId = OSCDestinationSet::getStreamIdFromToken(token);
+
+        for (auto* stream : streams)
+        {
+            if (stream->getStreamId() == streamId)
+            {
+                stream->pongReceived(token,
+                                     TransportClock::fromWords(message[1].getInt32(), message[2].getInt32()),
+                                     TransportClock::fromWords(message[3].getInt32(), message[4].getInt32()),
+                                     TransportClock::fromWords(message[5].getInt32(), message[6].getInt32()),
+                                     arrivalNs);
+                return;
+            }
+        }
+    }
+
+    // A binary packet goes to the stream with the sender's stream ID; one with no
+    // ID, or an ID no stream here has, goes to all of them
+    void routePacket(const char* data, int dataSize)
+    {
+        const auto arrivalNs = TransportClock::nowNs();
+        const auto streamId = dataSize > 0 ? BinaryTransportPacket::peekStreamId(data, static_cast<size_t>(dataSize)) : 0;
+
+        {
+            const juce::ScopedLock sl(streamsLock);
+            beginDelivery([streamId](const TransportStream& stream) { return streamId != 0 && stream.getStreamId() == streamId; });
+        }
+
+        for (auto* stream : deliveryTargets)
+            stream->getListener().binaryPacketReceived(data, dataSize, arrivalNs);
+
+        endDelivery();
+    }
+
+    // Called with streamsLock held. Fills deliveryTargets with the streams that
+    // claim a datagram, or every stream if none does, so the listeners can then
+    // be called after the lock is released.
+    template <typename Claims>
+    void beginDelivery(Claims&& claims)
+    {
+        deliveryTargets.clearQuick();
+
+        for (auto* stream : streams)
+            if (claims(*stream))
+                deliveryTargets.add(stream);
+
+        if (deliveryTargets.isEmpty())
+            deliveryTargets.addArray(streams);
+
+        ++deliveriesStarted;
+    }
+
+    void endDelivery() noexcept
+    {
+        deliveryTargets.clearQuick();
+        deliveriesFinished.fetch_add(1, std::memory_order_release);
+    }
+
+    // Receiver thread vs. instances coming and going. The sender thread keeps its own list,
+    // so a slow send never holds up incoming messages.
+    juce::CriticalSection streamsLock;
+    juce::Array<TransportStream*> streams;
+
+    // Receiver thread only, apart from the counters: removeStream() waits until every
+    // delivery started before the removal has finished
+    juce::Array<TransportStream*> deliveryTargets;
+    uint64_t deliveriesStarted = 0; // Guarded by streamsLock
+    std::atomic<uint64_t> deliveriesFinished { 0 };
+
+    static constexpr int connectionManagerStopTimeoutMs = 10000;
+
+    juce::DatagramSocket receiveSocket { false }; // Outlives the receiver and the sender thread's pings
+    OSCMessageSenderThread senderThread;
+    OSCConnectionManager connectionManager;
+    ClockSyncResponder clockSyncResponder;
+    juce::OSCReceiver receiver;
+    bool receiving = false;
+
+    // Message thread only
+    juce::String joinedGroup, joinedInterface;
+
+    JUCE_DECLARE_NON_COPYABLE(TransportEngine)
+};
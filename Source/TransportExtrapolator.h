@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * @class TransportExtrapolator
+ * @brief Receiver-side helper that turns sparse transport updates into a
+ *        continuously running ppq position.
+ *
+ *        Each update() anchors the timeline at (ppq, timestamp) and the
+ *        position runs forward from there at the last known tempo. When an
+ *        update disagrees with what we were predicting, the difference is
+ *        blended out over `correctionTimeSeconds` instead of being applied as
+ *        a step, so a display or clock driven from getPpqAt() keeps moving
+ *        smoothly even at a 5-10 Hz update rate. Jumps larger than
+ *        `snapThresholdBeats` (locates, loops) are applied immediately.
+ *
+ *        All state is plain data, so the whole object can be copied or
+ *        published between threads as a value. Timestamps are nanoseconds in
+ *        any clock the caller likes, as long as update() and getPpqAt() agree.
+ */
+class TransportExtrapolator
+{
+public:
+    struct Settings
+    {
+        double correctionTimeSeconds   = 0.25; // Time constant of the error blend
+        double snapThresholdBeats      = 1.0;  // Bigger errors are applied as a jump
+        double maxExtrapolationSeconds = 2.0;  // Stop running forward if updates dry up
+    };
+
+    TransportExtrapolator() = default;
+    explicit TransportExtrapolator(const Settings& s) : settings(s) {}
+
+    void setSettings(const Settings& s) noexcept    { settings = s; }
+    const Settings& getSettings() const noexcept    { return settings; }
+
+    void update(bool isPlaying, double bpm, double ppq, uint64_t timestampNs) noexcept
+    {
+        double error = 0.0;
+
+        if (hasAnchor && isPlaying && playing)
+        {
+            error = getPpqAt(timestampNs) - ppq;
+
+            if (std::abs(error) > settings.snapThresholdBeats)
+                error = 0.0;
+        }
+
+        playing = isPlaying;
+        tempo = bpm > 0.0 ? bpm : tempo;
+        anchorPpq = ppq;
+        anchorNs = timestampNs;
+        correction = error;
+
+        // Never blend faster than half the playback rate, so the corrected
+        // position keeps moving forward instead of stalling or running back.
+        const double beatsPerSecond = tempo / 60.0;
+        correctionTime = settings.correctionTimeSeconds;
+
+        if (beatsPerSecond > 0.0)
+            correctionTime = std::max(correctionTime, 2.0 * std::abs(error) / beatsPerSecond);
+
+        hasAnchor = true;
+    }
+
+    // Tempo-only and play-state-only updates keep the current position running.
+    void updateTempo(double bpm, uint64_t timestampNs) noexcept
+    {
+        if (hasAnchor)
+            update(playing, bpm, getPpqAt(timestampNs), timestampNs);
+        else
+            tempo = bpm;
+    }
+
+    void updatePlayState(bool isPlaying, uint64_t timestampNs) noexcept
+    {
+        if (hasAnchor)
+            update(isPlaying, tempo, getPpqAt(timestampNs), timestampNs);
+        else
+            playing = isPlaying;
+    }
+
+    double getPpqAt(uint64_t nowNs) const noexcept
+    {
+        if (!hasAnchor)
+            return 0.0;
+
+        if (!playing)
+            return anchorPpq;
+
+        const double elapsed = std::min(secondsBetween(anchorNs, nowNs), settings.maxExtrapolationSeconds);
+        const double blend = correctionTime > 0.0 ? std::exp(-elapsed / correctionTime) : 0.0;
+
+        return anchorPpq + elapsed * tempo / 60.0 + correction * blend;
+    }
+
+    bool hasPosition() const noexcept   { return hasAnchor; }
+    bool isPlaying() const noexcept     { return playing; }
+    double getBpm() const noexcept      { return tempo; }
+
+    void reset() noexcept               { *this = TransportExtrapolator(settings); }
+
+private:
+    static double secondsBetween(uint64_t fromNs, uint64_t toNs) noexcept
+    {
+        return toNs > fromNs ? static_cast<double>(toNs - fromNs) * 1.0e-9 : 0.0;
+    }
+
+    Settings settings;
+
+    bool hasAnchor = false;
+    bool playing = false;
+    double tempo = 120.0;
+    double anchorPpq = 0.0;
+    uint64_t anchorNs = 0;
+
+    double correction = 0.0;      // Old prediction minus new anchor, decaying to zero
+    double correctionTime = 0.25;
+};
@@ -0,0 +1,495 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include "BinaryTransportPacket.h"
+#include "OSCTransportMessage.h"
+#include "SPSCRingBuffer.h"
+#include "TransportClock.h"
+
+// Recording needs mmap. Elsewhere the log compiles but open() always fails, so
+// the REC button just stays off.
+#ifndef TRANSPORT_LOG_SUPPORTED
+ #if defined(_WIN32)
+  #define TRANSPORT_LOG_SUPPORTED 0
+ #else
+  #define TRANSPORT_LOG_SUPPORTED 1
+ #endif
+#endif
+
+#if TRANSPORT_LOG_SUPPORTED
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+#endif
+
+/**
+ * @namespace TransportLog
+ * @brief Append-only binary recording of everything a stream sent, for
+ *        reproducing what receivers saw. Little-endian, fixed-size records:
+ *
+ *            header (one record slot, 96 bytes)
+ *                 0     8  magic "TSLOG\0\0\0"
+ *                 8     4  format version
+ *                12     4  record size
+ *                16     8  TransportClock time the log was opened
+ *                24     8  wall clock at that moment, ms since 1970, to line up with show logs
+ *
+ *            record (96 bytes)
+ *                 0     8  TransportClock time the update was handed to the socket
+ *                 8     8  host timeline sample the update refers to
+ *                16     2  stream id
+ *                18     6  reserved, 0
+ *                24    72  BinaryTransportPacket with its context extension,
+ *                          sequence = record index
+ *
+ *        A record is complete once its packet magic is present; the magic is
+ *        written last, so a reader stops cleanly at the first record a crash
+ *        cut short, and the zeroed space after the last record.
+ *
+ *        POSIX only (TRANSPORT_LOG_SUPPORTED); on Windows opening a log fails.
+ */
+namespace TransportLog
+{
+    static constexpr size_t recordSize = 96;
+    static constexpr size_t headerSize = recordSize;
+    static constexpr uint32_t formatVersion = 1;
+    static constexpr size_t packetOffset = 24;
+
+    static_assert(packetOffset + BinaryTransportPacket::sizeWithContext == recordSize, "record layout");
+
+    struct Record
+    {
+        uint64_t sentNs = 0;
+        int streamId = 0;
+        OSCTransportMessage message {};
+    };
+
+    namespace Detail
+    {
+        inline void store64(uint8_t* dest, uint64_t value) noexcept
+        {
+            for (int i = 0; i < 8; ++i)
+                dest[i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+
+        inline void store32(uint8_t* dest, uint32_t value) noexcept
+        {
+            for (int i = 0; i < 4; ++i)
+                dest[i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+
+        inline uint64_t load64(const uint8_t* src) noexcept
+        {
+            uint64_t value = 0;
+
+            for (int i = 7; i >= 0; --i)
+                value = (value << 8) | src[i];
+
+            return value;
+        }
+
+        inline uint32_t load32(const uint8_t* src) noexcept
+        {
+            return static_cast<uint32_t>(src[0]) | (static_cast<uint32_t>(src[1]) << 8)
+                 | (static_cast<uint32_t>(src[2]) << 16) | (static_cast<uint32_t>(src[3]) << 24);
+        }
+
+        static constexpr char magic[8] = { 'T', 'S', 'L', 'O', 'G', 0, 0, 0 };
+    }
+
+    //==============================================================================
+    /**
+     * @class Writer
+     * @brief Maps `capacityBytes` of address space up front, so append() is a
+     *        couple of memcpys into the page cache: no allocation and no lock.
+     *        The file itself starts at one growChunkBytes and is extended a
+     *        chunk at a time, each chunk's pages faulted in as it is added. A
+     *        crash leaves at most a chunk of zeroes, and close() trims the file
+     *        to what was written. Once the file reaches the capacity, or can't
+     *        grow, appends are counted as dropped.
+     *
+     *        open() and close() belong to one thread; append() and growAhead()
+     *        to one other, and never concurrently with open() or close().
+     *        Recorder below runs them on its own thread, off the send path.
+     */
+    class Writer
+    {
+    public:
+        static constexpr size_t defaultCapacityBytes = size_t { 256 } << 20; // 2.8M records: hours even at the 400 Hz burst rate
+        static constexpr size_t growChunkBytes = recordSize << 16;           // 6 MB, under 3 minutes at 400 Hz
+
+        Writer() = default;
+        ~Writer()   { close(); }
+
+        bool open(const char* path, size_t capacityBytes = defaultCapacityBytes)
+        {
+            close();
+
+           #if ! TRANSPORT_LOG_SUPPORTED
+            (void) path;
+            (void) capacityBytes;
+            return false;
+           #else
+            const int fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+            if (fd < 0)
+                return false;
+
+            // Pages past the end of the file must not be touched; append() grows it first
+            const size_t capacity = std::max(capacityBytes - capacityBytes % recordSize, headerSize + recordSize);
+            const size_t initialSize = std::min(capacity, growChunkBytes);
+
+            if (::ftruncate(fd, static_cast<off_t>(initialSize)) != 0)
+            {
+                ::close(fd);
+                return false;
+            }
+
+            void* mapped = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+            if (mapped == MAP_FAILED)
+            {
+                ::close(fd);
+                return false;
+            }
+
+            fileHandle = fd;
+            data = static_cast<uint8_t*>(mapped);
+            mappedSize = capacity;
+            fileSize = initialSize;
+            numRecords = 0;
+            numDropped = 0;
+
+            using namespace std::chrono;
+            std::memcpy(data, Detail::magic, sizeof(Detail::magic));
+            Detail::store32(data + 8, formatVersion);
+            Detail::store32(data + 12, static_cast<uint32_t>(recordSize));
+            Detail::store64(data + 16, TransportClock::nowNs());
+            Detail::store64(data + 24, static_cast<uint64_t>(duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count()));
+            return true;
+           #endif
+        }
+
+        // Returns false if the log is closed or full
+        bool append(const OSCTransportMessage& msg, int streamId, uint64_t sentNs) noexcept
+        {
+            if (data == nullptr)
+                return false;
+
+            const size_t offset = headerSize + numRecords.load(std::memory_order_relaxed) * recordSize;
+
+            if (offset + recordSize > fileSize && !grow())
+            {
+                numDropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            BinaryTransportPacket packet;
+            packet.flags = msg.isPlaying ? BinaryTransportPacket::isPlayingFlag : 0;
+            packet.sequence = static_cast<uint32_t>(numRecords.load(std::memory_order_relaxed));
+            packet.tickPosition = BinaryTransportPacket::ppqToTicks(msg.position);
+            packet.tempo = msg.tempo;
+            packet.hostTimeNs = msg.hostTimeNs;
+            packet.setContext(msg.context);
+
+            uint8_t encoded[BinaryTransportPacket::sizeWithContext];
+            packet.encode(encoded);
+
+            uint8_t* record = data + offset;
+            Detail::store64(record, sentNs);
+            Detail::store64(record + 8, static_cast<uint64_t>(msg.timeInSamples));
+            record[16] = static_cast<uint8_t>(streamId);
+            record[17] = static_cast<uint8_t>(streamId >> 8);
+            std::memcpy(record + packetOffset + 4, encoded + 4, sizeof(encoded) - 4);
+
+            // The magic marks the record complete, so it goes in last
+            std::atomic_thread_fence(std::memory_order_release);
+            std::memcpy(record + packetOffset, encoded, 4);
+
+            numRecords.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // Adds the next chunk once less than half of one is left, so append()
+        // itself almost never has to. Appending thread only.
+        void growAhead() noexcept
+        {
+            if (data == nullptr)
+                return;
+
+            const size_t used = headerSize + numRecords.load(std::memory_order_relaxed) * recordSize;
+
+            if (fileSize - used < growChunkBytes / 2)
+                grow();
+        }
+
+        // Unmaps and trims the file to the records written
+        void close()
+        {
+            if (data == nullptr)
+                return;
+
+           #if TRANSPORT_LOG_SUPPORTED
+            ::munmap(data, mappedSize);
+            [[maybe_unused]] const int result = ::ftruncate(fileHandle, static_cast<off_t>(headerSize + numRecords.load() * recordSize));
+            ::close(fileHandle);
+           #endif
+
+            data = nullptr;
+            fileHandle = -1;
+            mappedSize = 0;
+            fileSize = 0;
+        }
+
+        bool isOpen() const noexcept                { return data != nullptr; }
+        uint64_t getNumRecords() const noexcept     { return numRecords.load(std::memory_order_relaxed); }
+        uint64_t getNumDropped() const noexcept     { return numDropped.load(std::memory_order_relaxed); }
+
+    private:
+        // Extends the file by a chunk, up to the mapped capacity, and writes a
+        // zero into each new page so appends don't take the page faults.
+        // Appending thread only.
+        bool grow() noexcept
+        {
+           #if TRANSPORT_LOG_SUPPORTED
+            const size_t newSize = std::min(fileSize + growChunkBytes, mappedSize);
+
+            if (newSize > fileSize && ::ftruncate(fileHandle, static_cast<off_t>(newSize)) == 0)
+            {
+                const auto pageSize = static_cast<size_t>(std::max(4096L, ::sysconf(_SC_PAGESIZE)));
+                auto* pages = static_cast<volatile uint8_t*>(data);
+
+                for (size_t offset = fileSize; offset < newSize; offset += pageSize)
+                    pages[offset] = 0;
+
+                fileSize = newSize;
+                return true;
+            }
+           #endif
+
+            return false;
+        }
+
+        int fileHandle = -1;
+        uint8_t* data = nullptr;
+        size_t mappedSize = 0;  // Reserved address space
+        size_t fileSize = 0;    // How much of it the file backs
+        std::atomic<uint64_t> numRecords { 0 };
+        std::atomic<uint64_t> numDropped { 0 };
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+    };
+
+    //==============================================================================
+    /**
+     * @class Recorder
+     * @brief A Writer fed through an SPSCRingBuffer, so the thread that sends
+     *        updates only ever copies a Record into the ring: no lock, no file
+     *        calls and no page faults. The recorder's own thread drains the
+     *        ring every drainIntervalMs, appends, and grows the file ahead of
+     *        the records.
+     *
+     *        start() and stop() belong to one thread (the message thread);
+     *        push() to one other (the sender thread).
+     */
+    class Recorder
+    {
+    public:
+        static constexpr size_t queueCapacity = 2048;  // Five seconds even at the 400 Hz burst rate
+        static constexpr int drainIntervalMs = 10;
+
+        Recorder() = default;
+        ~Recorder()     { stop(); }
+
+        // Replaces any recording in progress
+        bool start(const char* path, size_t capacityBytes = Writer::defaultCapacityBytes)
+        {
+            stop();
+
+            if (!writer.open(path, capacityBytes))
+                return false;
+
+            // Anything pushed while stopped or stopping is older than this, and dropped
+            startNs = TransportClock::nowNs();
+            threadShouldExit.store(false, std::memory_order_relaxed);
+            thread = std::thread([this] { run(); });
+            recording.store(true, std::memory_order_release);
+            return true;
+        }
+
+        // Writes out whatever is queued, then closes the log
+        void stop()
+        {
+            recording.store(false, std::memory_order_release);
+
+            if (thread.joinable())
+            {
+                threadShouldExit.store(true, std::memory_order_release);
+                thread.join();
+            }
+
+            writer.close();
+        }
+
+        bool isRecording() const noexcept           { return recording.load(std::memory_order_acquire); }
+        uint64_t getNumRecords() const noexcept     { return isRecording() ? writer.getNumRecords() : 0; }
+        uint64_t getNumDropped() const noexcept     { return queue.getNumDropped() + writer.getNumDropped(); }
+
+        // Sender thread. Wait-free; a full queue drops the record and counts it.
+        void push(const OSCTransportMessage& msg, int streamId, uint64_t sentNs) noexcept
+        {
+            if (!isRecording())
+                return;
+
+            Record record;
+            record.sentNs = sentNs;
+            record.streamId = streamId;
+            record.message = msg;
+            queue.push(record);
+        }
+
+    private:
+        void run()
+        {
+            for (;;)
+            {
+                const bool exiting = threadShouldExit.load(std::memory_order_acquire);
+                Record record;
+
+                while (queue.pop(record))
+                    if (record.sentNs >= startNs)
+                        writer.append(record.message, record.streamId, record.sentNs);
+
+                writer.growAhead();
+
+                if (exiting)
+                    return;
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(drainIntervalMs));
+            }
+        }
+
+        Writer writer;
+        SPSCRingBuffer<Record, queueCapacity> queue;
+        std::thread thread;
+        uint64_t startNs = 0;
+        std::atomic<bool> recording { false };
+        std::atomic<bool> threadShouldExit { false };
+
+        Recorder(const Recorder&) = delete;
+        Recorder& operator=(const Recorder&) = delete;
+    };
+
+    //==============================================================================
+    /**
+     * @class Reader
+     * @brief Maps a log read-only and decodes its records in place.
+     */
+    class Reader
+    {
+    public:
+        Reader() = default;
+        ~Reader()   { close(); }
+
+        bool open(const char* path)
+        {
+            close();
+
+           #if ! TRANSPORT_LOG_SUPPORTED
+            (void) path;
+            return false;
+           #else
+            const int fd = ::open(path, O_RDONLY);
+
+            if (fd < 0)
+                return false;
+
+            struct stat info {};
+
+            if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < headerSize)
+            {
+                ::close(fd);
+                return false;
+            }
+
+            void* mapped = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+
+            if (mapped == MAP_FAILED)
+                return false;
+
+            data = static_cast<const uint8_t*>(mapped);
+            mappedSize = static_cast<size_t>(info.st_size);
+
+            if (std::memcmp(data, Detail::magic, sizeof(Detail::magic)) != 0
+                || Detail::load32(data + 8) != formatVersion || Detail::load32(data + 12) != recordSize)
+            {
+                close();
+                return false;
+            }
+
+            // Complete records only: stop at the first one without its magic
+            numRecords = 0;
+
+            for (size_t offset = headerSize; offset + recordSize <= mappedSize; offset += recordSize, ++numRecords)
+                if (!BinaryTransportPacket::isBinaryTransportPacket(data + offset + packetOffset, BinaryTransportPacket::sizeWithContext))
+                    break;
+
+            return true;
+           #endif
+        }
+
+        void close()
+        {
+           #if TRANSPORT_LOG_SUPPORTED
+            if (data != nullptr)
+                ::munmap(const_cast<uint8_t*>(data), mappedSize);
+           #endif
+
+            data = nullptr;
+            mappedSize = 0;
+            numRecords = 0;
+        }
+
+        size_t getNumRecords() const noexcept   { return numRecords; }
+        uint64_t getStartNs() const noexcept    { return data != nullptr ? Detail::load64(data + 16) : 0; }
+        int64_t getStartWallClockMs() const noexcept  { return data != nullptr ? static_cast<int64_t>(Detail::load64(data + 24)) : 0; }
+
+        bool read(size_t index, Record& record) const noexcept
+        {
+            if (index >= numRecords)
+                return false;
+
+            const uint8_t* src = data + headerSize + index * recordSize;
+            BinaryTransportPacket packet;
+
+            if (!BinaryTransportPacket::decode(src + packetOffset, BinaryTransportPacket::sizeWithContext, packet))
+                return false;
+
+            record.sentNs = Detail::load64(src);
+            record.streamId = src[16] | (src[17] << 8);
+            record.message.isPlaying = packet.isPlaying();
+            record.message.tempo = packet.tempo;
+            record.message.position = packet.getPpqPosition();
+            record.message.hostTimeNs = packet.hostTimeNs;
+            record.message.timeInSamples = static_cast<int64_t>(Detail::load64(src + 8));
+            record.message.context = packet.context;
+            return true;
+        }
+
+    private:
+        const uint8_t* data = nullptr;
+        size_t mappedSize = 0;
+        size_t numRecords = 0;
+
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+    };
+}
@@ -0,0 +1,264 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * @class TransportPhaseTracker
+ * @brief Receiver-side delay-locked loop that turns coarse, jittery transport
+ *        messages into a continuous ppq position with sub-millisecond phase.
+ *
+ *        /tempo gives the nominal rate. Each position message (Ableton's
+ *        bar | beat | sixteenth arrives as each 16th starts, so it is an exact
+ *        phase at its arrival time) is compared with the loop's prediction,
+ *        and the error drives a second-order loop: a proportional term pulls
+ *        the phase in, and an integral term trims the rate to absorb clock
+ *        drift between the two machines. The loop runs wide while acquiring
+ *        and narrows once locked, when it also clips single late packets to a
+ *        few times the running error, so network jitter is averaged away.
+ *
+ *        Phase corrections are slewed in over the expected time to the next
+ *        message rather than applied as steps, and never slow playback by more
+ *        than half, so getPpqAt() is continuous and never runs backwards.
+ *        Errors beyond `relocationBeats` (locates, loops) are taken as a jump
+ *        and restart acquisition.
+ *
+ *        getStatus() reports whether the loop is locked and how confident it
+ *        is, from a running RMS of the phase error. All state is plain data, so
+ *        the object can be published between threads as a value. Timestamps
+ *        are nanoseconds in any clock, as long as every call agrees.
+ */
+class TransportPhaseTracker
+{
+public:
+    struct Settings
+    {
+        double acquisitionBandwidthHz  = 1.0;   // Loop bandwidth until locked: pull in fast
+        double bandwidthHz             = 0.1;   // Once locked: average jitter away
+        double relocationBeats         = 0.5;   // Bigger errors are a jump, not jitter
+        double lockThresholdMs         = 2.0;   // RMS phase error that still counts as locked
+        int    updatesToLock           = 4;     // Consecutive good updates before declaring lock
+        double maxRateCorrection       = 0.05;  // Limit on the drift term, as a fraction of tempo
+        double maxExtrapolationSeconds = 2.0;   // Stop running forward if updates dry up
+    };
+
+    enum class Lock { unlocked, acquiring, locked };
+
+    struct Status
+    {
+        Lock lock = Lock::unlocked;
+        double confidence = 0.0;    // 0..1
+        double phaseErrorMs = 0.0;  // Running RMS of the error at each update
+        double rateCorrection = 0.0; // Fractional rate trim the loop has settled on
+    };
+
+    TransportPhaseTracker() = default;
+    explicit TransportPhaseTracker(const Settings& s) : settings(s) {}
+
+    void setSettings(const Settings& s) noexcept    { settings = s; }
+    const Settings& getSettings() const noexcept    { return settings; }
+
+    // A position observation, with the tempo that came with it
+    void update(bool isPlaying, double bpm, double ppq, uint64_t timestampNs) noexcept
+    {
+        if (bpm > 0.0)
+            setNominalTempo(bpm, timestampNs);
+
+        if (isPlaying != playing)
+            updatePlayState(isPlaying, timestampNs);
+
+        if (!hasAnchor || !playing)
+        {
+            anchorAt(ppq, timestampNs);
+            lastObservationNs = timestampNs;
+            return;
+        }
+
+        const double predicted = getPpqAt(timestampNs);
+        const double error = ppq - predicted;
+        const double beatsPerSecond = getBeatsPerSecond();
+
+        if (std::abs(error) > settings.relocationBeats || beatsPerSecond <= 0.0)
+        {
+            anchorAt(ppq, timestampNs);
+            lastObservationNs = timestampNs;
+            restartAcquisition();
+            return;
+        }
+
+        trackError(error / beatsPerSecond * 1000.0);
+
+        // A locked loop trusts its own prediction over a single outlier
+        const bool isLocked = hasAcquired();
+        double loopError = error;
+
+        if (isLocked)
+        {
+            const double limitBeats = std::max(settings.lockThresholdMs, 3.0 * std::sqrt(std::max(0.0, meanSquareErrorMs))) * beatsPerSecond / 1000.0;
+            loopError = std::clamp(error, -limitBeats, limitBeats);
+        }
+
+        // Second-order loop, with gains worked out for the actual interval
+        const double dt = std::clamp(secondsBetween(lastObservationNs, timestampNs), 0.001, 1.0);
+        const double w = 2.0 * pi * (isLocked ? settings.bandwidthHz : settings.acquisitionBandwidthHz) * dt;
+        const double b = std::min(std::sqrt(2.0) * w, 1.0);
+        const double c = std::min(w * w, 1.0);
+
+        rateCorrection = std::clamp(rateCorrection + c * loopError / (dt * nominalBpm / 60.0),
+                                    -settings.maxRateCorrection, settings.maxRateCorrection);
+
+        // Slew the phase correction in until the next message is expected,
+        // never eating more than half of the forward motion
+        anchorAt(predicted, timestampNs);
+        slewSeconds = dt;
+        slewBeats = std::max(b * loopError, -0.5 * getBeatsPerSecond() * slewSeconds);
+
+        lastObservationNs = timestampNs;
+    }
+
+    // A tempo-only message keeps the position running from where it is
+    void updateTempo(double bpm, uint64_t timestampNs) noexcept
+    {
+        if (bpm > 0.0)
+            setNominalTempo(bpm, timestampNs);
+    }
+
+    void updatePlayState(bool isPlaying, uint64_t timestampNs) noexcept
+    {
+        if (isPlaying == playing)
+            return;
+
+        if (hasAnchor)
+            anchorAt(getPpqAt(timestampNs), timestampNs);
+
+        playing = isPlaying;
+        lastObservationNs = timestampNs;
+        restartAcquisition();
+    }
+
+    double getPpqAt(uint64_t nowNs) const noexcept
+    {
+        if (!hasAnchor)
+            return 0.0;
+
+        if (!playing)
+            return anchorPpq;
+
+        const double elapsed = std::min(secondsBetween(anchorNs, nowNs), settings.maxExtrapolationSeconds);
+        const double slewed = slewSeconds > 0.0 ? slewBeats * std::min(1.0, elapsed / slewSeconds) : 0.0;
+
+        return anchorPpq + elapsed * getBeatsPerSecond() + slewed;
+    }
+
+    // Lock degrades to unlocked if messages stop arriving while playing
+    Status getStatus(uint64_t nowNs) const noexcept
+    {
+        Status status;
+        status.phaseErrorMs = std::sqrt(std::max(0.0, meanSquareErrorMs));
+        status.rateCorrection = rateCorrection;
+
+        if (!hasAnchor || !playing || secondsBetween(lastObservationNs, nowNs) > settings.maxExtrapolationSeconds)
+            return status;
+
+        const double errorRatio = status.phaseErrorMs / std::max(settings.lockThresholdMs, 1.0e-3);
+        const double acquired = std::min(1.0, goodUpdates / static_cast<double>(std::max(1, settings.updatesToLock)));
+
+        status.confidence = acquired / (1.0 + errorRatio * errorRatio);
+        status.lock = hasAcquired() && errorRatio <= 1.0 ? Lock::locked : Lock::acquiring;
+        return status;
+    }
+
+    bool hasPosition() const noexcept   { return hasAnchor; }
+    bool isPlaying() const noexcept     { return playing; }
+    double getBpm() const noexcept      { return nominalBpm * (1.0 + rateCorrection); }
+
+    void reset() noexcept               { *this = TransportPhaseTracker(settings); }
+
+private:
+    static constexpr double pi = 3.14159265358979323846;
+
+    static double secondsBetween(uint64_t fromNs, uint64_t toNs) noexcept
+    {
+        return toNs > fromNs ? static_cast<double>(toNs - fromNs) * 1.0e-9 : 0.0;
+    }
+
+    double getBeatsPerSecond() const noexcept   { return nominalBpm / 60.0 * (1.0 + rateCorrection); }
+
+    // Enough consecutive good updates to narrow the loop and, error permitting, report lock
+    bool hasAcquired() const noexcept           { return goodUpdates >= settings.updatesToLock; }
+
+    void setNominalTempo(double bpm, uint64_t timestampNs) noexcept
+    {
+        if (bpm == nominalBpm)
+            return;
+
+        // Re-anchor so the tempo change only affects the position from now on,
+        // carrying over whatever part of the current slew hasn't been applied yet
+        if (hasAnchor)
+        {
+            const double elapsed = std::min(secondsBetween(anchorNs, timestampNs), settings.maxExtrapolationSeconds);
+            const double remaining = slewSeconds > elapsed ? slewBeats * (1.0 - elapsed / slewSeconds) : 0.0;
+            const double remainingSeconds = slewSeconds - elapsed;
+
+            anchorAt(getPpqAt(timestampNs), timestampNs);
+            slewBeats = remaining;
+            slewSeconds = remaining != 0.0 ? remainingSeconds : 0.0;
+        }
+
+        nominalBpm = bpm;
+    }
+
+    void anchorAt(double ppq, uint64_t timestampNs) noexcept
+    {
+        anchorPpq = ppq;
+        anchorNs = timestampNs;
+        slewBeats = 0.0;
+        slewSeconds = 0.0;
+        hasAnchor = true;
+    }
+
+    void restartAcquisition() noexcept
+    {
+        goodUpdates = 0;
+        badUpdates = 0;
+        meanSquareErrorMs = -1.0;
+    }
+
+    void trackError(double errorMs) noexcept
+    {
+        // Seed the average with the first error so lock isn't declared on an empty history
+        const double squared = errorMs * errorMs;
+        meanSquareErrorMs = meanSquareErrorMs < 0.0 ? squared : meanSquareErrorMs + errorSmoothing * (squared - meanSquareErrorMs);
+
+        // One late packet doesn't lose lock; a run of them does
+        if (std::abs(errorMs) <= settings.lockThresholdMs * 2.0)
+        {
+            goodUpdates = std::min(goodUpdates + 1, 1 << 20);
+            badUpdates = 0;
+        }
+        else if (++badUpdates >= settings.updatesToLock)
+        {
+            goodUpdates = 0;
+        }
+    }
+
+    static constexpr double errorSmoothing = 0.2;
+
+    Settings settings;
+
+    bool hasAnchor = false;
+    bool playing = false;
+    double nominalBpm = 120.0;
+    double rateCorrection = 0.0;
+
+    double anchorPpq = 0.0;
+    uint64_t anchorNs = 0;
+    double slewBeats = 0.0;
+    double slewSeconds = 0.0;
+    uint64_t lastObservationNs = 0;
+
+    int goodUpdates = 0;
+    int badUpdates = 0;
+    double meanSquareErrorMs = -1.0; // Negative until the first error after (re)acquisition
+};
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @class TransportRateController
+ * @brief Decides when processBlock should publish a transport update.
+ *
+ *        Instead of a fixed interval, it keeps track of what receivers last
+ *        heard and predicts what they are showing now (last position run
+ *        forward at the last tempo, exactly what TransportExtrapolator does).
+ *        An update is due when that prediction drifts further than
+ *        `maxPositionErrorMs` from the host, when the tempo moves by more than
+ *        `tempoThresholdBpm`, or when `keyframeIntervalSeconds` has passed with
+ *        nothing to say. Steady playback therefore costs only keyframes.
+ *        Relocations are flushed immediately, ignoring the burst limit.
+ *
+ *        getSendOffset() gives at most one offset per block. Hosts report one
+ *        tempo per block, so a second update within the block would carry
+ *        nothing new. A tempo ramp therefore bursts up to the lower of
+ *        1 / `minIntervalSeconds` and sampleRate / blockSize: about 94 Hz at
+ *        48 kHz with 512-sample blocks, and the full 400 Hz only with blocks
+ *        under 2.5 ms.
+ *
+ *        Times are seconds on a continuous processed-sample clock, not the host
+ *        timeline, so loops and locates don't confuse the scheduling.
+ */
+class TransportRateController
+{
+public:
+    struct Settings
+    {
+        double maxPositionErrorMs      = 2.0;
+        double tempoThresholdBpm       = 0.05;
+        double keyframeIntervalSeconds = 0.1;    // 10 Hz floor while playing
+        double stoppedKeyframeIntervalSeconds = 1.0;
+        double minIntervalSeconds      = 0.0025; // 400 Hz burst ceiling; blocks longer than this lower it
+        double relocationBeats         = 0.25;   // Bigger errors are a jump, sent at once
+    };
+
+    struct State
+    {
+        bool isPlaying = false;
+        double ppq = 0.0;
+        double bpm = 120.0;
+    };
+
+    enum class Reason { none, first, relocation, tempoChange, positionError, keyframe };
+
+    void setSettings(const Settings& s) noexcept    { settings = s; }
+    const Settings& getSettings() const noexcept    { return settings; }
+
+    void reset() noexcept                           { hasSent = false; }
+
+    // Looks at one block and returns the sample offset within it at which an
+    // update is due, or -1 if nothing needs sending this block. `reason` says why.
+    int getSendOffset(const State& blockStart, double blockStartSeconds,
+                      int numSamples, double sampleRate, Reason& reason) const noexcept
+    {
+        reason = Reason::none;
+
+        if (numSamples <= 0 || sampleRate <= 0.0)
+            return -1;
+
+        if (!hasSent)
+        {
+            reason = Reason::first;
+            return 0;
+        }
+
+        const double error = blockStart.ppq - predictPpq(blockStartSeconds);
+        const double beatsPerMs = std::max(blockStart.bpm, 1.0) / 60000.0;
+        const double maxError = settings.maxPositionErrorMs * beatsPerMs;
+
+        if (std::abs(error) >= settings.relocationBeats || blockStart.isPlaying != lastSent.isPlaying)
+        {
+            reason = Reason::relocation;
+            return 0;
+        }
+
+        double dueSeconds = lastSentSeconds + (blockStart.isPlaying ? settings.keyframeIntervalSeconds
+                                                                    : settings.stoppedKeyframeIntervalSeconds);
+        reason = Reason::keyframe;
+
+        if (std::abs(blockStart.bpm - lastSent.bpm) >= settings.tempoThresholdBpm)
+        {
+            dueSeconds = blockStartSeconds;
+            reason = Reason::tempoChange;
+        }
+        else if (std::abs(error) >= maxError)
+        {
+            dueSeconds = blockStartSeconds;
+            reason = Reason::positionError;
+        }
+        else if (blockStart.isPlaying)
+        {
+            // The prediction error grows with the tempo difference; work out
+            // where in the block it will cross the threshold.
+            const double errorSlope = (blockStart.bpm - lastSent.bpm) / 60.0;
+            const double headroom = maxError - std::abs(error);
+
+            if (errorSlope != 0.0 && (errorSlope > 0.0) == (error >= 0.0))
+            {
+                const double crossingSeconds = blockStartSeconds + headroom / std::abs(errorSlope);
+
+                if (crossingSeconds < dueSeconds)
+                {
+                    dueSeconds = crossingSeconds;
+                    reason = Reason::positionError;
+                }
+            }
+        }
+
+        dueSeconds = std::max(dueSeconds, lastSentSeconds + settings.minIntervalSeconds);
+
+        const double offset = std::ceil((dueSeconds - blockStartSeconds) * sampleRate);
+
+        if (offset >= numSamples)
+        {
+            reason = Reason::none;
+            return -1;
+        }
+
+        return std::max(0, static_cast<int>(offset));
+    }
+
+    // Record what receivers now have: call for every update actually published,
+    // including play/stop events, with the state at the sample it describes.
+    void markSent(const State& sent, double timeSeconds) noexcept
+    {
+        lastSent = sent;
+        lastSentSeconds = timeSeconds;
+        hasSent = true;
+    }
+
+    double predictPpq(double timeSeconds) const noexcept
+    {
+        if (!lastSent.isPlaying)
+            return lastSent.ppq;
+
+        return lastSent.ppq + (timeSeconds - lastSentSeconds) * lastSent.bpm / 60.0;
+    }
+
+private:
+    Settings settings;
+
+    bool hasSent = false;
+    State lastSent;
+    double lastSentSeconds = 0.0;
+};
@@ -0,0 +1,329 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <juce_osc/juce_osc.h>
+#include "SPSCRingBuffer.h"
+#include "SeqLockSnapshot.h"
+#include "OSCTransportMessage.h"
+#include "OSCTransportEncoder.h"
+#include "OSCDestinationSet.h"
+#include "BinaryTransportPacket.h"
+#include "TransportTelemetry.h"
+#include "TransportLog.h"
+
+// Wait-free hand-off between processBlock (producer) and the sender thread (consumer).
+// Only discrete events (play/stop) go through the queue; they must each be sent.
+using OSCTransportQueue = SPSCRingBuffer<OSCTransportMessage, 256>;
+
+// The newest transport update. Periodic position updates only ever need the
+// latest value, so they are published here instead of queued.
+using OSCTransportSnapshot = SeqLockSnapshot<OSCTransportMessage>;
+
+/**
+ * @class TransportStream
+ * @brief One plugin instance's share of the process-wide TransportEngine.
+ *
+ *        The stream holds everything that belongs to a single instance: its
+ *        event queue and latest-update snapshot (written by that instance's
+ *        processBlock), its destinations and wire format, and its address
+ *        prefix. The engine's one sender thread calls sendPending() on every
+ *        registered stream, and its one receiver hands each stream the
+ *        incoming messages addressed to it.
+ *
+ *        A stream with an empty prefix sends plain /play, /tempo... as before.
+ *        With a prefix such as "/deck2" it sends /deck2/play and so on, and
+ *        incoming /deck2/... messages go to it alone with the prefix removed.
+ *        Unprefixed incoming messages (e.g. from Ableton) go to every stream.
+ */
+class TransportStream
+{
+public:
+    struct Listener
+    {
+        virtual ~Listener() = default;
+
+        // Both run on the engine's receiver thread. `address` has the stream's prefix
+        // removed; `arrivalNs` is TransportClock time taken once per datagram, so
+        // every stream sees the same arrival however many there are.
+        virtual void oscMessageReceived(const juce::String& address, const juce::OSCMessage& message, uint64_t arrivalNs) = 0;
+        virtual void binaryPacketReceived(const char* data, int dataSize, uint64_t arrivalNs) = 0;
+    };
+
+    explicit TransportStream(Listener& l) : listener(l) {}
+
+    //==============================================================================
+    // Audio thread (single producer)
+
+    // Returns false if the queue is full; the caller keeps the event and retries.
+    // Every attempt samples the queue depth, so the high-water mark misses no peak.
+    bool pushEvent(const OSCTransportMessage& msg) noexcept
+    {
+        const bool pushed = events.push(msg);
+        telemetry.recordQueueDepth(events.getNumReady());
+        return pushed;
+    }
+
+    // Only the newest position matters, so this replaces rather than queues
+    void publish(const OSCTransportMessage& msg) noexcept { latestUpdate.publish(msg); }
+
+    bool hasPendingEvents() const noexcept { return !events.isEmpty(); }
+    int getNumPendingEvents() const noexcept { return events.getNumReady(); }
+    uint64_t getNumDroppedEvents() const noexcept { return events.getNumDropped(); }
+
+    // Counters and latency histograms; the audio thread records into it directly
+    TransportTelemetry& getTelemetry() noexcept { return telemetry; }
+    const TransportTelemetry& getTelemetry() const noexcept { return telemetry; }
+
+    //==============================================================================
+    // Configuration, from any non-realtime thread
+
+    // Returns at once; the OSCConnectionManager looks the addresses up, so neither
+    // the caller nor the sender ever waits on DNS
+    bool setDestinations(const juce::Array<OSCDestination>& newDestinations) { return destinations.setDestinations(newDestinations); }
+    juce::Array<OSCDestination> getDestinations() const { return destinations.getDestinations(); }
+    juce::Array<OSCDestinationSet::Stats> getDestinationStats() const { return destinations.getStats(); }
+    OSCDestinationSet::LinkState getLinkState() const { return destinations.getLinkState(); }
+    OSCDestinationSet::LinkSummary getLinkSummary() const { return destinations.getLinkSummary(); }
+
+    // Bundle mode packs /play, /tempo and /position into one timetagged
+    // datagram, so receivers never see a new tempo paired with an old position.
+    void setUseBundles(bool shouldUseBundles) { useBundles = shouldUseBundles; }
+    bool isUsingBundles() const { return useBundles; }
+
+    // Opt-in compact wire format for high-rate links: one BinaryTransportPacket
+    // per update instead of OSC. Receivers must understand it.
+    void setUseBinaryFormat(bool shouldUseBinary) { useBinaryFormat = shouldUseBinary; }
+    bool isUsingBinaryFormat() const { return useBinaryFormat; }
+
+    // Whether the once-a-second report also goes out to the destinations as /stats.
+    // Off by default: most receivers have no use for it.
+    void setPublishStats(bool shouldPublish) { publishStats = shouldPublish; }
+    bool isPublishingStats() const { return publishStats; }
+
+    // "deck2", "/deck2" and "/deck2/" all give the prefix "/deck2"; an empty string
+    // removes it. Message thread only.
+    void setAddressPrefix(const juce::String& newPrefix)
+    {
+        auto cleaned = newPrefix.trim().removeCharacters(" #*,?[]{}").trimCharactersAtEnd("/");
+
+        if (cleaned.isNotEmpty() && !cleaned.startsWithChar('/'))
+            cleaned = "/" + cleaned;
+
+        PrefixText text;
+        cleaned.copyToUTF8(text.chars, sizeof(text.chars));
+        prefix.publish(text);
+    }
+
+    juce::String getAddressPrefix() const { return juce::String::fromUTF8(prefix.read().chars); }
+
+    // Appends every update this stream sends to a TransportLog at `file`,
+    // replacing any recording in progress. Message thread only.
+    bool startRecording(const juce::File& file)
+    {
+        return file.getParentDirectory().createDirectory() && recorder.start(file.getFullPathName().toRawUTF8());
+    }
+
+    void stopRecording()                            { recorder.stop(); }
+    bool isRecording() const noexcept               { return recorder.isRecording(); }
+    uint64_t getNumRecordedUpdates() const noexcept { return recorder.getNumRecords(); }
+
+    // Assigned by the engine when the stream is added; unique among live streams, 0 before that
+    int getStreamId() const noexcept { return streamId; }
+
+    //==============================================================================
+    // Engine side
+
+    void setStreamId(int newId) noexcept { streamId = newId; }
+    Listener& getListener() noexcept { return listener; }
+
+    // True if `address` carries this stream's prefix, setting `localAddress` to
+    // the address without it. Receiver thread.
+    bool claimsAddress(const juce::String& address, juce::String& localAddress) const
+    {
+        const auto ownPrefix = getAddressPrefix();
+
+        if (ownPrefix.isEmpty() || !address.startsWith(ownPrefix + "/"))
+            return false;
+
+        localAddress = address.substring(ownPrefix.length());
+        return true;
+    }
+
+    // Destination lookups, see OSCDestinationSet::beginLookup(). Connection manager thread only.
+    bool beginLookup(OSCDestinationSet::Lookup& lookup, int& msUntilDue) const { return destinations.beginLookup(lookup, msUntilDue); }
+    void completeLookup(const OSCDestinationSet::Lookup& lookup) { destinations.completeLookup(lookup); }
+
+    // Clock sync with each destination, see OSCDestinationSet::sendPings(). Sender thread only.
+    void sendPings(juce::DatagramSocket& socket, int clockSyncPort) { destinations.sendPings(socket, encoder, streamId, clockSyncPort); }
+
+    // Receiver thread
+    void pongReceived(int32_t token, uint64_t t1, uint64_t t2, uint64_t t3, uint64_t t4)
+    {
+        destinations.pongReceived(token, t1, t2, t3, t4);
+    }
+
+    // Closes a telemetry interval and sends it as /stats. Sender thread only.
+    void sendTelemetry(juce::DatagramSocket& socket)
+    {
+        const auto stats = destinations.getStats();
+        telemetry.publishReport(stats, events.getNumDropped(), TransportClock::nowNs());
+
+        if (!publishStats)
+            return;
+
+        const auto report = telemetry.getReport();
+        const auto prefixText = prefix.read();
+
+        for (int first = 0; first == 0 || first < stats.size(); first += TransportTelemetry::maxDestinationsPerBundle)
+        {
+            const auto& packet = TransportTelemetry::encodeReport(statsWriter, prefixText.chars, streamId, report, stats, first);
+
+            if (packet.hasOverflowed() || destinations.sendToAll(socket, packet.getData(), packet.getSize()) == 0)
+                DBG("Failed to send /stats");
+        }
+    }
+
+    // Sends queued events and the latest update if it changed. Sender thread only.
+    void sendPending(juce::DatagramSocket& socket)
+    {
+        OSCTransportMessage msg;
+
+        while (events.pop(msg))
+            sendIfNewer(socket, msg);
+
+        uint64_t version = 0;
+        msg = latestUpdate.read(&version);
+
+        if (version != lastSentVersion)
+        {
+            lastSentVersion = version;
+            sendIfNewer(socket, msg);
+        }
+    }
+
+private:
+    // Trivially copyable so the sender thread can pick up prefix changes without a lock
+    struct PrefixText
+    {
+        char chars[OSCTransportEncoder::maxPrefixLength + 1] {};
+    };
+
+    // Never send anything older than what receivers already have. Events are
+    // also published as the latest update, so this also stops them going out twice.
+    // Ordered by the producer's sequence rather than host time, which can go
+    // backwards when the host restarts, changes device or is reset.
+    void sendIfNewer(juce::DatagramSocket& socket, const OSCTransportMessage& msg)
+    {
+        if (msg.sequence <= lastSentSequence)
+            return;
+
+        lastSentSequence = msg.sequence;
+        sendTransportMessage(socket, msg);
+
+        // A copy into the recorder's queue; its own thread does the file work
+        recorder.push(msg, streamId, TransportClock::nowNs());
+
+        if (msg.publishedNs != 0)
+            telemetry.recordWireLatency(TransportClock::nowNs() - msg.publishedNs);
+    }
+
+    // Time signature, loop, bar and so on ride along only when they differ from
+    // what was last sent, or once a contextKeyframeIntervalNs so that receivers
+    // joining late (or missing a packet) catch up
+    bool isContextDue(const OSCTransportMessage& msg, uint64_t nowNs) const noexcept
+    {
+        return !hasSentContext || msg.context != lastSentContext || nowNs - lastContextSentNs >= contextKeyframeIntervalNs;
+    }
+
+    void sendTransportMessage(juce::DatagramSocket& socket, const OSCTransportMessage& msg)
+    {
+        const auto nowNs = TransportClock::nowNs();
+        const bool includeContext = isContextDue(msg, nowNs);
+
+        if (includeContext)
+        {
+            lastSentContext = msg.context;
+            lastContextSentNs = nowNs;
+            hasSentContext = true;
+        }
+
+        if (useBinaryFormat)
+        {
+            BinaryTransportPacket packet;
+            packet.streamId = static_cast<uint8_t>(juce::isPositiveAndBelow(streamId, 256) ? streamId : 0);
+            packet.flags = msg.isPlaying ? BinaryTransportPacket::isPlayingFlag : 0;
+            packet.sequence = binarySequence++;
+            packet.tickPosition = BinaryTransportPacket::ppqToTicks(msg.position);
+            packet.tempo = msg.tempo;
+            packet.hostTimeNs = msg.hostTimeNs;
+
+            if (includeContext)
+                packet.setContext(msg.context);
+
+            packet.encode(binaryBuffer);
+
+            if (destinations.sendToAll(socket, reinterpret_cast<const char*>(binaryBuffer), packet.getEncodedSize()) == 0)
+                DBG("Failed to send binary transport packet");
+
+            return;
+        }
+
+        encoder.setAddressPrefix(prefix.read().chars);
+
+        if (useBundles)
+        {
+            if (!sendPacket(socket, encoder.encodeBundle(msg, includeContext), true))
+                DBG("Failed to send transport bundle");
+
+            return;
+        }
+
+        // Context first, so /timestamp still closes the update for receivers that wait for it
+        if (includeContext)
+            for (auto field : OSCTransportEncoder::contextFields)
+                if (!sendPacket(socket, encoder.encodeMessage(field, msg)))
+                    DBG("Failed to send " + juce::String(OSCTransportEncoder::getAddress(field)) + " message");
+
+        for (auto field : OSCTransportEncoder::allFields)
+            if (!sendPacket(socket, encoder.encodeMessage(field, msg)))
+                DBG("Failed to send " + juce::String(OSCTransportEncoder::getAddress(field)) + " message");
+    }
+
+    bool sendPacket(juce::DatagramSocket& socket, const OSCPacketWriter& packet, bool isBundle = false)
+    {
+        if (packet.hasOverflowed())
+            return false;
+
+        return destinations.sendToAll(socket, packet.getData(), packet.getSize(), isBundle) > 0;
+    }
+
+    Listener& listener;
+    int streamId = 0;
+
+    OSCTransportQueue events;
+    OSCTransportSnapshot latestUpdate;
+    SeqLockSnapshot<PrefixText> prefix;
+
+    std::atomic<bool> useBundles { true };
+    std::atomic<bool> useBinaryFormat { false };
+    std::atomic<bool> publishStats { false };
+    OSCDestinationSet destinations;
+    TransportTelemetry telemetry;
+
+    TransportLog::Recorder recorder; // The sender thread pushes, the message thread starts and stops
+
+    // Sender thread's state
+    OSCTransportEncoder encoder;
+    OSCPacketWriter statsWriter;
+    uint32_t binarySequence = 0;
+    uint8_t binaryBuffer[BinaryTransportPacket::sizeWithContext] {};
+    uint64_t lastSentVersion = 1; // The snapshot's initial, empty value
+    uint64_t lastSentSequence = 0; // Producers start at 1
+    TransportContext lastSentContext;
+    uint64_t lastContextSentNs = 0;
+    bool hasSentContext = false;
+
+    static constexpr uint64_t contextKeyframeIntervalNs = 1000000000; // 1 s
+
+    JUCE_DECLARE_NON_COPYABLE(TransportStream)
+};
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include "OSCDestinationSet.h"
+#include "OSCTransportEncoder.h"
+#include "SeqLockSnapshot.h"
+
+/**
+ * @class LatencyHistogram
+ * @brief Lock-free log2 histogram of durations. record() is a few relaxed
+ *        atomic adds, safe from the audio thread and from several writers.
+ *        Bucket i holds durations below 2^i microseconds, so percentiles
+ *        come back as a bucket's upper edge: within a factor of two, which is
+ *        enough to see where time goes.
+ *
+ *        Percentiles are taken over an interval by diffing two snapshots, so
+ *        recording never has to be paused or reset.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr int numBuckets = 32; // Up to ~35 minutes
+
+    struct Snapshot
+    {
+        std::array<uint64_t, numBuckets> buckets {};
+        uint64_t count = 0;
+        uint64_t totalNs = 0;
+    };
+
+    struct Summary
+    {
+        uint64_t count = 0;
+        uint64_t meanNs = 0;
+        uint64_t p50Ns = 0;
+        uint64_t p99Ns = 0;
+        uint64_t maxNs = 0; // Largest bucket edge seen in the interval
+    };
+
+    void record(uint64_t ns) noexcept
+    {
+        buckets[static_cast<size_t>(bucketFor(ns))].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        totalNs.fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    Snapshot snapshot() const noexcept
+    {
+        Snapshot s;
+
+        for (size_t i = 0; i < buckets.size(); ++i)
+            s.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+
+        s.count = count.load(std::memory_order_relaxed);
+        s.totalNs = totalNs.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    // What was recorded between two snapshots of the same histogram
+    static Summary summarise(const Snapshot& now, const Snapshot& before) noexcept
+    {
+        Summary summary;
+        summary.count = now.count - before.count;
+
+        if (summary.count == 0)
+            return summary;
+
+        summary.meanNs = (now.totalNs - before.totalNs) / summary.count;
+
+        const uint64_t p50Rank = (summary.count + 1) / 2;
+        const uint64_t p99Rank = summary.count - summary.count / 100;
+        uint64_t seen = 0;
+
+        for (int i = 0; i < numBuckets; ++i)
+        {
+            const auto inBucket = now.buckets[static_cast<size_t>(i)] - before.buckets[static_cast<size_t>(i)];
+
+            if (inBucket == 0)
+                continue;
+
+            const auto before50 = seen;
+            seen += inBucket;
+
+            if (before50 < p50Rank && seen >= p50Rank) summary.p50Ns = upperEdgeNs(i);
+            if (before50 < p99Rank && seen >= p99Rank) summary.p99Ns = upperEdgeNs(i);
+
+            summary.maxNs = upperEdgeNs(i);
+        }
+
+        return summary;
+    }
+
+private:
+    static int bucketFor(uint64_t ns) noexcept
+    {
+        auto us = ns / 1000;
+        int bucket = 0;
+
+        while (us > 0 && bucket < numBuckets - 1)
+        {
+            us >>= 1;
+            ++bucket;
+        }
+
+        return bucket;
+    }
+
+    static uint64_t upperEdgeNs(int bucket) noexcept    { return (uint64_t { 1 } << bucket) * 1000; }
+
+    std::array<std::atomic<uint64_t>, numBuckets> buckets {};
+    std::atomic<uint64_t> count { 0 };
+    std::atomic<uint64_t> totalNs { 0 };
+};
+
+/**
+ * @class TransportTelemetry
+ * @brief Per-instance counters for the send pipeline.
+ *
+ *        The audio thread records processBlock time and, on every push, the
+ *        event queue's depth; the sender thread records how long each update
+ *        took from being published to being handed to the socket, and the
+ *        receiver thread counts what it had to drop as malformed. Once a
+ *        second the sender thread turns the raw counters into a Report, which
+ *        the editor reads and which can be sent to the destinations as /stats
+ *        (see encodeReport()).
+ */
+class TransportTelemetry
+{
+public:
+    struct Report
+    {
+        double intervalSeconds = 0.0;
+
+        juce::uint64 packetsSent = 0;   // Totals over all destinations, since the start
+        juce::uint64 bytesSent = 0;
+        juce::uint64 sendFailures = 0;
+        juce::uint64 queueDrops = 0;
+        juce::uint64 malformedReceived = 0;  // Datagrams and messages the receiver couldn't use
+        double packetsPerSecond = 0.0;  // Over the last interval
+
+        int queueHighWater = 0;         // Deepest the event queue got in the last interval
+        int numDestinations = 0;
+        int numHealthyDestinations = 0;
+
+        LatencyHistogram::Summary wireLatency;   // Publish in processBlock to socket write
+        LatencyHistogram::Summary processTime;   // processBlock duration
+        double dspLoadPercent = 0.0;             // processBlock time / audio time
+    };
+
+    //==============================================================================
+    // Audio thread
+
+    void recordProcessBlock(uint64_t elapsedNs, double blockSeconds) noexcept
+    {
+        processTime.record(elapsedNs);
+        processBusyNs.fetch_add(elapsedNs, std::memory_order_relaxed);
+        processAudioNs.fetch_add(static_cast<uint64_t>(blockSeconds * 1.0e9), std::memory_order_relaxed);
+    }
+
+    void recordQueueDepth(int depth) noexcept
+    {
+        auto current = queueHighWater.load(std::memory_order_relaxed);
+
+        while (depth > current && !queueHighWater.compare_exchange_weak(current, depth, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    //==============================================================================
+    // Receiver thread
+
+    void recordMalformedReceived() noexcept         { malformedReceived.fetch_add(1, std::memory_order_relaxed); }
+
+    //==============================================================================
+    // Sender thread
+
+    void recordWireLatency(uint64_t ns) noexcept    { wireLatency.record(ns); }
+
+    // Closes the current interval. Sender thread only, as it owns the previous snapshots.
+    void publishReport(const juce::Array<OSCDestinationSet::Stats>& destinations, juce::uint64 queueDrops, uint64_t nowNs)
+    {
+        Report report;
+        report.intervalSeconds = lastReportNs != 0 ? (nowNs - lastReportNs) * 1.0e-9 : 0.0;
+        report.queueDrops = queueDrops;
+        report.malformedReceived = malformedReceived.load(std::memory_order_relaxed);
+        report.queueHighWater = queueHighWater.exchange(0, std::memory_order_relaxed);
+        report.numDestinations = destinations.size();
+
+        for (auto& d : destinations)
+        {
+            report.packetsSent += d.packetsSent;
+            report.bytesSent += d.bytesSent;
+            report.sendFailures += d.sendFailures;
+            report.numHealthyDestinations += d.isHealthy ? 1 : 0;
+        }
+
+        // Replacing the destination list restarts its counters, so the total can go down
+        const auto sentInInterval = report.packetsSent >= lastPacketsSent ? report.packetsSent - lastPacketsSent : 0;
+
+        if (report.intervalSeconds > 0.0)
+            report.packetsPerSecond = sentInInterval / report.intervalSeconds;
+
+        const auto wireNow = wireLatency.snapshot();
+        const auto processNow = processTime.snapshot();
+        report.wireLatency = LatencyHistogram::summarise(wireNow, lastWire);
+        report.processTime = LatencyHistogram::summarise(processNow, lastProcess);
+
+        const auto busyNs = processBusyNs.load(std::memory_order_relaxed);
+        const auto audioNs = processAudioNs.load(std::memory_order_relaxed);
+
+        if (audioNs > lastAudioNs)
+            report.dspLoadPercent = 100.0 * (busyNs - lastBusyNs) / (double) (audioNs - lastAudioNs);
+
+        lastWire = wireNow;
+        lastProcess = processNow;
+        lastBusyNs = busyNs;
+        lastAudioNs = audioNs;
+        lastPacketsSent = report.packetsSent;
+        lastReportNs = nowNs;
+
+        latestReport.publish(report);
+    }
+
+    //==============================================================================
+    // Any thread
+
+    Report getReport() const noexcept               { return latestReport.read(); }
+    uint64_t getReportVersion() const noexcept      { return latestReport.getVersion(); }
+
+    /** /stats carries the summary for one stream, and /stats/destination one
+        link, each under the stream's address prefix. Counters are totals that
+        wrap at 2^31; receivers diff them for rates.
+
+            /stats  i streamId  i packets  i bytes  i failures  i drops  i queueHighWater
+                    f wireP50Ms  f wireP99Ms  f wireMaxMs  f processP99Us  f dspLoadPercent
+
+            /stats/destination  s host:port  i packets  i bytes  i failures  i healthy  f rttMs
+
+        The summary and up to `maxDestinationsPerBundle` links share one bundle;
+        call again with the next `firstDestination` for the rest.
+    */
+    static const OSCPacketWriter& encodeReport(OSCPacketWriter& writer, const char* prefix, int streamId, const Report& report,
+                                               const juce::Array<OSCDestinationSet::Stats>& destinations, int firstDestination)
+    {
+        writer.reset();
+        writer.beginBundle(1); // "Immediately"
+
+        if (firstDestination == 0)
+        {
+            writer.beginMessage(prefix, "/stats", "iiiiiifffff");
+            writer.addInt32(streamId);
+            writer.addInt32(toWrappingInt(report.packetsSent));
+            writer.addInt32(toWrappingInt(report.bytesSent));
+            writer.addInt32(toWrappingInt(report.sendFailures));
+            writer.addInt32(toWrappingInt(report.queueDrops));
+            writer.addInt32(report.queueHighWater);
+            writer.addFloat32(static_cast<float>(report.wireLatency.p50Ns / 1.0e6));
+            writer.addFloat32(static_cast<float>(report.wireLatency.p99Ns / 1.0e6));
+            writer.addFloat32(static_cast<float>(report.wireLatency.maxNs / 1.0e6));
+            writer.addFloat32(static_cast<float>(report.processTime.p99Ns / 1.0e3));
+            writer.addFloat32(static_cast<float>(report.dspLoadPercent));
+            writer.endMessage();
+        }
+
+        const int end = juce::jmin(destinations.size(), firstDestination + maxDestinationsPerBundle);
+
+        for (int i = firstDestination; i < end; ++i)
+        {
+            const auto& d = destinations.getReference(i);
+            writer.beginMessage(prefix, "/stats/destination", "siiiif");
+            writer.addString(d.name.toRawUTF8());
+            writer.addInt32(toWrappingInt(d.packetsSent));
+            writer.addInt32(toWrappingInt(d.bytesSent));
+            writer.addInt32(toWrappingInt(d.sendFailures));
+            writer.addInt32(d.isHealthy ? 1 : 0);
+            writer.addFloat32(static_cast<float>(d.roundTripMs));
+            writer.endMessage();
+        }
+
+        writer.endBundle();
+        return writer;
+    }
+
+    static constexpr int maxDestinationsPerBundle = 8;
+
+private:
+    static int32_t toWrappingInt(juce::uint64 value) noexcept   { return static_cast<int32_t>(value & 0x7fffffff); }
+
+    LatencyHistogram wireLatency;
+    LatencyHistogram processTime;
+    std::atomic<int> queueHighWater { 0 };
+    std::atomic<uint64_t> processBusyNs { 0 };
+    std::atomic<uint64_t> processAudioNs { 0 };
+    std::atomic<uint64_t> malformedReceived { 0 };
+
+    // Sender thread's view at the last report
+    LatencyHistogram::Snapshot lastWire, lastProcess;
+    uint64_t lastBusyNs = 0, lastAudioNs = 0;
+    juce::uint64 lastPacketsSent = 0;
+    uint64_t lastReportNs = 0;
+
+    SeqLockSnapshot<Report> latestReport;
+};
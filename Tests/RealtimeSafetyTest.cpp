@@ -0,0 +1,105 @@
+/*
+    RealtimeSafetyTest: RealtimeSafety.cpp built with TRANSPORT_REALTIME_CHECKS=1.
+    Covers an allocation, a free, a lock and a sleep inside a ScopedAudioThread
+    each being counted, the same calls outside it or under ScopedAllow not
+    being counted, and a clean audio-thread scope reporting nothing.
+
+    Linux/macOS only, no JUCE. Built and run by Tests/Makefile.
+*/
+
+#include <cstdio>
+#include <mutex>
+#include <new>
+#include <unistd.h>
+
+#include "RealtimeSafety.h"
+
+static int failures = 0;
+
+#define EXPECT(condition) \
+    do { if (!(condition)) { std::printf("%s:%d: FAILED: %s\n", __FILE__, __LINE__, #condition); ++failures; } } while (false)
+
+using Kind = RealtimeSafety::ViolationKind;
+
+// Called directly rather than through a new-expression, which the optimiser may elide
+static void* volatile allocation = nullptr;
+
+static void allocate()  { allocation = ::operator new(64); }
+static void release()   { ::operator delete(allocation); allocation = nullptr; }
+
+static std::mutex mutex;
+
+static void testCleanScope()
+{
+    const auto before = RealtimeSafety::getNumViolations();
+
+    {
+        RealtimeSafety::ScopedAudioThread audio("clean");
+        volatile int sum = 0;
+
+        for (int i = 0; i < 100; ++i)
+            sum = sum + i;
+
+        std::unique_lock<std::mutex> attempt(mutex, std::try_to_lock);    // try-locks are allowed
+    }
+
+    EXPECT(RealtimeSafety::getNumViolations() == before);
+}
+
+static void testOutsideScope()
+{
+    const auto before = RealtimeSafety::getNumViolations();
+
+    allocate();
+    release();
+    { std::lock_guard<std::mutex> lock(mutex); }
+    usleep(0);
+
+    EXPECT(RealtimeSafety::getNumViolations() == before);
+}
+
+static void testViolationsCounted()
+{
+    const auto allocations = RealtimeSafety::getNumViolations(Kind::allocation);
+    const auto deallocations = RealtimeSafety::getNumViolations(Kind::deallocation);
+    const auto locks = RealtimeSafety::getNumViolations(Kind::lock);
+    const auto blockingCalls = RealtimeSafety::getNumViolations(Kind::blockingCall);
+
+    {
+        RealtimeSafety::ScopedAudioThread audio("violating");
+        allocate();
+        release();
+        { std::lock_guard<std::mutex> lock(mutex); }
+        usleep(0);
+    }
+
+    EXPECT(RealtimeSafety::getNumViolations(Kind::allocation) == allocations + 1);
+    EXPECT(RealtimeSafety::getNumViolations(Kind::deallocation) == deallocations + 1);
+    EXPECT(RealtimeSafety::getNumViolations(Kind::lock) == locks + 1);
+    EXPECT(RealtimeSafety::getNumViolations(Kind::blockingCall) == blockingCalls + 1);
+}
+
+static void testAllowed()
+{
+    const auto before = RealtimeSafety::getNumViolations();
+
+    {
+        RealtimeSafety::ScopedAudioThread audio("allowed");
+        RealtimeSafety::ScopedAllow allow;
+        allocate();
+        release();
+    }
+
+    EXPECT(RealtimeSafety::getNumViolations() == before);
+}
+
+int main()
+{
+    testCleanScope();
+    testOutsideScope();
+    testViolationsCounted();
+    testAllowed();
+
+    std::printf("RealtimeSafetyTest: %s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
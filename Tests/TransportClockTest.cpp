@@ -0,0 +1,99 @@
+/*
+    TransportClockTest: HostClockMapper, the step that puts the host's
+    PositionInfo::getHostTimeNs() into TransportClock::nowNs() terms before
+    snapshots are stamped with it.
+
+    No JUCE. Built and run by Tests/Makefile.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "TransportClock.h"
+
+static int failures = 0;
+
+#define EXPECT(condition) \
+    do { if (!(condition)) { std::printf("%s:%d: FAILED: %s\n", __FILE__, __LINE__, #condition); ++failures; } } while (false)
+
+static int64_t difference(uint64_t a, uint64_t b) { return static_cast<int64_t>(a - b); }
+static int64_t magnitude(int64_t value)           { return value < 0 ? -value : value; }
+
+// No host time: the block is stamped with our own clock, untouched
+static void fallbackUsesLocalClock()
+{
+    TransportClock::HostClockMapper mapper;
+
+    EXPECT(mapper.getBlockTimeNs(std::nullopt, 123456789ull) == 123456789ull);
+
+    const auto now = TransportClock::nowNs();
+    EXPECT(mapper.getBlockTimeNs(std::nullopt, now) == now);
+}
+
+// A host clock hours away from ours, read with a few hundred microseconds of
+// scheduling jitter each block, lands within that jitter of our clock
+static void hostTimeIsMovedIntoLocalDomain()
+{
+    TransportClock::HostClockMapper mapper;
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int64_t> jitter(0, 300000);
+
+    const uint64_t blockNs = 10666667; // 512 samples at 48 kHz
+    const uint64_t hostStartNs = 5000000000000ull;
+    const uint64_t localStartNs = 17000000000000ull;
+
+    for (int block = 0; block < 2000; ++block)
+    {
+        const auto hostNs = hostStartNs + block * blockNs;
+        const auto trueLocalNs = localStartNs + block * blockNs;
+        const auto mappedNs = mapper.getBlockTimeNs(hostNs, trueLocalNs + static_cast<uint64_t>(jitter(random)));
+
+        EXPECT(magnitude(difference(mappedNs, trueLocalNs)) <= 300000);
+
+        // Once settled, consecutive blocks stay within jitter of the host's own spacing
+        if (block > 200)
+            EXPECT(magnitude(difference(mappedNs, trueLocalNs) - 150000) < 60000);
+    }
+}
+
+// Host time arriving after fallback blocks doesn't jump away from local time
+static void switchingPathsStaysContinuous()
+{
+    TransportClock::HostClockMapper mapper;
+    const uint64_t localNs = 9000000000ull;
+
+    const auto fallback = mapper.getBlockTimeNs(std::nullopt, localNs);
+    const auto mapped = mapper.getBlockTimeNs(42ull, localNs + 1000);
+
+    EXPECT(fallback == localNs);
+    EXPECT(mapped == localNs + 1000);
+}
+
+// The host resetting its clock re-anchors at once rather than drifting over
+static void hostClockJumpResyncs()
+{
+    TransportClock::HostClockMapper mapper;
+    uint64_t localNs = 1000000000000ull;
+
+    for (int block = 0; block < 100; ++block, localNs += 10000000)
+        mapper.getBlockTimeNs(localNs - 777000000ull, localNs);
+
+    EXPECT(mapper.getBlockTimeNs(3000000ull, localNs) == localNs);
+    localNs += 10000000;
+    EXPECT(mapper.getBlockTimeNs(13000000ull, localNs) == localNs);
+
+    mapper.reset();
+    EXPECT(mapper.getBlockTimeNs(1ull, localNs + 5) == localNs + 5);
+}
+
+int main()
+{
+    fallbackUsesLocalClock();
+    hostTimeIsMovedIntoLocalDomain();
+    switchingPathsStaysContinuous();
+    hostClockJumpResyncs();
+
+    std::printf("TransportClockTest: %s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,123 @@
+/*
+    TransportLogTest: a Recorder fed from another thread, read back with a
+    Reader. Covers the file growing past its first chunk on the recorder's
+    own thread, records surviving in order, and a restart beginning a fresh
+    log.
+
+    POSIX only, no JUCE. Built and run by Tests/Makefile.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#include "TransportLog.h"
+
+static int failures = 0;
+
+#define EXPECT(condition) \
+    do { if (!(condition)) { std::printf("%s:%d: FAILED: %s\n", __FILE__, __LINE__, #condition); ++failures; } } while (false)
+
+static OSCTransportMessage makeUpdate(int i)
+{
+    OSCTransportMessage msg;
+    msg.isPlaying = (i % 3) != 0;
+    msg.tempo = 120.0 + i % 7;
+    msg.position = i * 0.25;
+    msg.hostTimeNs = 1000000ull * static_cast<uint64_t>(i);
+    msg.timeInSamples = i * 512;
+    return msg;
+}
+
+// Pushes from a thread of its own, at about 50k updates a second: far above any
+// real send rate, yet slow enough that the queue never fills between drains
+static void pushUpdates(TransportLog::Recorder& recorder, int count, int streamId)
+{
+    std::thread sender([&]
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            recorder.push(makeUpdate(i), streamId, TransportClock::nowNs());
+
+            if (i % 250 == 249)
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    });
+
+    sender.join();
+}
+
+static void recordsSurviveGrowth(const std::string& path)
+{
+    // More than one growChunkBytes of records, so the recorder thread has to grow the file
+    const int count = static_cast<int>(TransportLog::Writer::growChunkBytes / TransportLog::recordSize) + 5000;
+
+    TransportLog::Recorder recorder;
+    EXPECT(recorder.start(path.c_str(), TransportLog::Writer::growChunkBytes * 4));
+    EXPECT(recorder.isRecording());
+
+    pushUpdates(recorder, count, 3);
+    recorder.stop();
+
+    EXPECT(!recorder.isRecording());
+    EXPECT(recorder.getNumDropped() == 0);
+
+    TransportLog::Reader reader;
+    EXPECT(reader.open(path.c_str()));
+    EXPECT(reader.getNumRecords() == static_cast<size_t>(count));
+
+    for (size_t i = 0; i < reader.getNumRecords(); i += 997)
+    {
+        TransportLog::Record record;
+        EXPECT(reader.read(i, record));
+
+        const auto expected = makeUpdate(static_cast<int>(i));
+        EXPECT(record.streamId == 3);
+        EXPECT(record.message.isPlaying == expected.isPlaying);
+        EXPECT(record.message.tempo == expected.tempo);
+        EXPECT(record.message.position == expected.position);
+        EXPECT(record.message.timeInSamples == expected.timeInSamples);
+    }
+
+    // close() trims the file to the records written
+    struct stat info {};
+    EXPECT(::stat(path.c_str(), &info) == 0);
+    EXPECT(static_cast<size_t>(info.st_size) == TransportLog::headerSize + count * TransportLog::recordSize);
+}
+
+static void restartBeginsFreshLog(const std::string& path)
+{
+    TransportLog::Recorder recorder;
+
+    recorder.push(makeUpdate(0), 1, TransportClock::nowNs()); // Not recording: ignored
+    EXPECT(recorder.getNumRecords() == 0);
+
+    EXPECT(recorder.start(path.c_str()));
+    pushUpdates(recorder, 100, 1);
+    EXPECT(recorder.start(path.c_str())); // Replaces the first recording
+    pushUpdates(recorder, 10, 2);
+    recorder.stop();
+
+    TransportLog::Reader reader;
+    EXPECT(reader.open(path.c_str()));
+    EXPECT(reader.getNumRecords() == 10);
+
+    TransportLog::Record record;
+    EXPECT(reader.read(0, record) && record.streamId == 2);
+}
+
+int main()
+{
+    const std::string path = "/tmp/TransportLogTest-" + std::to_string(::getpid()) + ".tslog";
+
+    recordsSurviveGrowth(path);
+    restartBeginsFreshLog(path);
+    ::unlink(path.c_str());
+
+    std::printf("TransportLogTest: %s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <cstdio>
+
+#include "../../../Source/BinaryTransportPacket.h"
+#include "../../../Source/OSCTransportEncoder.h"
+#include "../../../Source/RealtimeSafety.h"
+#include "../../../Source/TransportClock.h"
+
+/**
+ * @namespace EncoderBenchmark
+ * @brief OSCTransportEncoder against the juce::OSCSender calls it replaced,
+ *        and BinaryTransportPacket against both: time and heap allocations
+ *        per transport update, encoding only and encoding plus the socket
+ *        write, and for the binary format decoding too. Packets go to a
+ *        loopback socket that is never read, so the kernel drops them once
+ *        its buffer fills.
+ *
+ *        Allocations are counted by RealtimeSafety in a separate pass, as
+ *        recording each one's backtrace would swamp the timings. Figures
+ *        measured so far, and which rows still need a run, are in README.md.
+ */
+namespace EncoderBenchmark
+{
+    struct Result
+    {
+        const char* name;
+        double nsPerUpdate;
+        double allocationsPerUpdate;
+    };
+
+    inline OSCTransportMessage makeUpdate(int i)
+    {
+        OSCTransportMessage msg;
+        msg.isPlaying = true;
+        msg.tempo = 120.0 + (i % 64) * 0.25;
+        msg.position = i * 0.0625;
+        msg.hostTimeNs = TransportClock::nowNs();
+        return msg;
+    }
+
+    template <typename SendUpdate>
+    Result measure(const char* name, int iterations, SendUpdate&& sendUpdate)
+    {
+        constexpr int warmUp = 1000, counted = 1000;
+
+        for (int i = 0; i < warmUp; ++i)
+            sendUpdate(makeUpdate(i));
+
+        const auto startNs = TransportClock::nowNs();
+
+        for (int i = 0; i < iterations; ++i)
+            sendUpdate(makeUpdate(i));
+
+        const auto elapsedNs = TransportClock::nowNs() - startNs;
+        const auto allocationsBefore = RealtimeSafety::getNumViolations(RealtimeSafety::ViolationKind::allocation);
+
+        {
+            const RealtimeSafety::ScopedAudioThread countAllocations("encoder benchmark");
+
+            for (int i = 0; i < counted; ++i)
+                sendUpdate(makeUpdate(i));
+        }
+
+        const auto allocations = RealtimeSafety::getNumViolations(RealtimeSafety::ViolationKind::allocation) - allocationsBefore;
+        return { name, (double) elapsedNs / iterations, (double) allocations / counted };
+    }
+
+    inline int run(int iterations)
+    {
+        juce::DatagramSocket sink;
+        juce::DatagramSocket socket;
+
+        if (!sink.bindToPort(0, "127.0.0.1"))
+        {
+            std::fprintf(stderr, "can't bind the benchmark's sink\n");
+            return 1;
+        }
+
+        const juce::String host("127.0.0.1");
+        const int port = sink.getBoundPort();
+
+        OSCTransportEncoder encoder;
+        juce::OSCSender sender;
+        sender.connect(host, port);
+
+        const auto write = [&](const OSCPacketWriter& packet)
+        {
+            socket.write(host, port, packet.getData(), (int) packet.getSize());
+        };
+
+        uint8_t binary[BinaryTransportPacket::size] {};
+        BinaryTransportPacket packet;
+        uint32_t sequence = 0;
+
+        const auto encodeBinary = [&](const OSCTransportMessage& msg)
+        {
+            packet.flags = msg.isPlaying ? BinaryTransportPacket::isPlayingFlag : 0;
+            packet.sequence = sequence++;
+            packet.tickPosition = BinaryTransportPacket::ppqToTicks(msg.position);
+            packet.tempo = msg.tempo;
+            packet.hostTimeNs = msg.hostTimeNs;
+            packet.encode(binary);
+        };
+
+        const Result results[] = {
+            measure("encoder: bundle, encode only", iterations, [&](const OSCTransportMessage& msg)
+            {
+                encoder.encodeBundle(msg);
+            }),
+
+            measure("encoder: bundle + write", iterations, [&](const OSCTransportMessage& msg)
+            {
+                write(encoder.encodeBundle(msg));
+            }),
+
+            measure("encoder: 4 messages + writes", iterations, [&](const OSCTransportMessage& msg)
+            {
+                for (auto field : OSCTransportEncoder::allFields)
+                    write(encoder.encodeMessage(field, msg));
+            }),
+
+            measure("binary: encode only", iterations, [&](const OSCTransportMessage& msg)
+            {
+                encodeBinary(msg);
+            }),
+
+            measure("binary: encode + write", iterations, [&](const OSCTransportMessage& msg)
+            {
+                encodeBinary(msg);
+                socket.write(host, port, binary, (int) sizeof(binary));
+            }),
+
+            measure("binary: decode", iterations, [&](const OSCTransportMessage&)
+            {
+                BinaryTransportPacket decoded;
+                BinaryTransportPacket::decode(binary, sizeof(binary), decoded);
+                sequence += decoded.sequence & 1; // Keeps the decode from being optimised away
+            }),
+
+            // What processBlock used to do for every update
+            measure("juce::OSCSender: /play /tempo /position", iterations, [&](const OSCTransportMessage& msg)
+            {
+                sender.send("/play", msg.isPlaying ? 1 : 0);
+                sender.send("/tempo", (float) msg.tempo);
+                sender.send("/position", (float) msg.position);
+            })
+        };
+
+        std::printf("%-42s %12s %14s\n", "per update", "ns", "allocations");
+
+        for (auto& r : results)
+            std::printf("%-42s %12.0f %14.2f\n", r.name, r.nsPerUpdate, r.allocationsPerUpdate);
+
+        return 0;
+    }
+}
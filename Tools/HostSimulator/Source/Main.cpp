@@ -0,0 +1,625 @@
+/*
+    HostSimulator: runs TransportSenderV1AudioProcessor the way a host would,
+    with no audio device, no editor and no plugin wrapper, and measures it.
+
+    A scripted play head starts and stops the transport, ramps the tempo,
+    loops a beat, changes time signature and jumps forwards and back, over
+    every combination of the sample rates and block sizes asked for (by
+    default 44.1, 48 and 96 kHz; 16 to 4096 samples). Blocks are paced in
+    real time unless --fast is given. The plugin sends to a UDP sink on
+    loopback, and each run reports:
+
+      - block time      processBlock's own time, p50/p99/max, and the worst
+                        block as a share of its audio duration
+      - realtime        allocations, frees, locks and blocking calls made
+                        inside processBlock (RealtimeSafety, which this target
+                        always builds with)
+      - wire            publish in processBlock to socket write, from the
+                        plugin's own telemetry: mean, worst 1 s p99, max
+      - end to end      when each update's position was true to its arrival at
+                        the sink, p50/p99/max; paced runs only
+      - packets         datagrams the sink received, and their rate
+
+    The exit status is non-zero if processBlock broke a realtime rule, the
+    sink got nothing, or (with --max-load) a block took longer than that
+    percentage of its own duration, so it can gate performance changes.
+
+    Open HostSimulator.jucer in the Projucer and build the Linux Makefile or
+    Xcode exporter; on Linux:
+
+        cd Tools/HostSimulator/Builds/LinuxMakefile && make CONFIG=Release
+
+    Examples:
+
+        HostSimulator
+        HostSimulator --rates=48000 --blocks=16,4096 --seconds=10
+        HostSimulator --fast --format=binary --max-load=5
+
+    --encoder-benchmark instead times OSCTransportEncoder against the
+    juce::OSCSender calls it replaced, and counts their allocations; see
+    EncoderBenchmark.h.
+
+    --self-test checks the checker: a block that allocates must show up in
+    RealtimeSafety's count, and a clean one must not. It exits non-zero if
+    either is wrong, e.g. because the allocator hooks weren't linked in.
+*/
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../../../Source/PluginProcessor.h"
+#include "../../../Source/RealtimeSafety.h"
+#include "EncoderBenchmark.h"
+
+namespace
+{
+    enum class Format { bundle, messages, binary };
+
+    struct Options
+    {
+        juce::Array<double> sampleRates { 44100.0, 48000.0, 96000.0 };
+        juce::Array<int> blockSizes { 16, 64, 256, 1024, 4096 };
+        double seconds = 4.0;           // Per run
+        bool fast = false;              // Run blocks back to back instead of in real time
+        Format format = Format::bundle;
+        double maxLoadPercent = 0.0;    // 0 = no limit
+        int benchmarkIterations = 0;    // --encoder-benchmark; runs that instead
+        bool selfTest = false;          // --self-test; runs that instead
+    };
+
+    //==============================================================================
+    // A host transport driven by a fixed script. The steps are placed at
+    // fractions of the run, so every run covers all of them whatever its length.
+    class ScriptedPlayHead : public juce::AudioPlayHead
+    {
+    public:
+        ScriptedPlayHead(double sampleRateToUse, double runSeconds)
+            : sampleRate(sampleRateToUse), length(runSeconds) {}
+
+        // Applies the steps due by now and describes the block about to be processed
+        void beginBlock(uint64_t hostTimeNs)
+        {
+            const double t = elapsedSeconds / length;
+
+            for (; nextStep < std::size(script) && script[nextStep].at <= t; ++nextStep)
+                apply(script[nextStep].action);
+
+            if (isRamping)
+            {
+                const double u = juce::jlimit(0.0, 1.0, (t - rampStart) / rampLength);
+                bpm = rampFromBpm + (rampToBpm - rampFromBpm) * u;
+                isRamping = u < 1.0;
+            }
+
+            const double barLength = numerator * 4.0 / denominator;
+
+            info = {};
+            info.setIsPlaying(isPlaying);
+            info.setBpm(bpm);
+            info.setPpqPosition(ppq);
+            info.setTimeInSamples(timeInSamples);
+            info.setTimeInSeconds(timeInSamples / sampleRate);
+            info.setHostTimeNs(hostTimeNs);
+            info.setTimeSignature(juce::AudioPlayHead::TimeSignature { numerator, denominator });
+            info.setPpqPositionOfLastBarStart(std::floor(ppq / barLength) * barLength);
+            info.setIsLooping(isLooping);
+
+            if (isLooping)
+                info.setLoopPoints(juce::AudioPlayHead::LoopPoints { loopStart, loopEnd });
+        }
+
+        void endBlock(int numSamples)
+        {
+            const double blockSeconds = numSamples / sampleRate;
+
+            if (isPlaying)
+            {
+                ppq += blockSeconds * bpm / 60.0;
+                timeInSamples += numSamples;
+
+                if (isLooping && ppq >= loopEnd)
+                    ppq = loopStart + std::fmod(ppq - loopStart, loopEnd - loopStart);
+            }
+
+            elapsedSeconds += blockSeconds;
+        }
+
+        juce::Optional<PositionInfo> getPosition() const override { return info; }
+
+    private:
+        enum class Action { play, stop, rampTempo, loopBeat, changeTimeSignature, endLoop, jumpForward, rewind };
+
+        struct Step
+        {
+            double at; // Fraction of the run
+            Action action;
+        };
+
+        static constexpr Step script[] = {
+            { 0.05, Action::play },
+            { 0.10, Action::rampTempo },            // 120 -> 160 bpm over 30% of the run
+            { 0.40, Action::loopBeat },             // Loops the current beat, wrapping every beat
+            { 0.50, Action::changeTimeSignature },  // 7/8
+            { 0.60, Action::endLoop },
+            { 0.62, Action::jumpForward },          // 16 bars on
+            { 0.70, Action::stop },
+            { 0.75, Action::play },
+            { 0.85, Action::rewind },               // Back to the start while playing
+            { 0.95, Action::stop }
+        };
+
+        void apply(Action action)
+        {
+            switch (action)
+            {
+                case Action::play:                  isPlaying = true; break;
+                case Action::stop:                  isPlaying = false; break;
+                case Action::rampTempo:             isRamping = true; rampStart = elapsedSeconds / length; rampFromBpm = bpm; break;
+                case Action::loopBeat:              isLooping = true; loopStart = std::floor(ppq); loopEnd = loopStart + 1.0; break;
+                case Action::changeTimeSignature:   numerator = 7; denominator = 8; break;
+                case Action::endLoop:               isLooping = false; break;
+                case Action::jumpForward:           ppq += 16.0 * numerator * 4.0 / denominator; timeInSamples += (int64_t) (sampleRate * 30.0); break;
+                case Action::rewind:                ppq = 0.0; timeInSamples = 0; break;
+            }
+        }
+
+        const double sampleRate, length;
+        size_t nextStep = 0;
+        double elapsedSeconds = 0.0;
+
+        bool isPlaying = false;
+        double bpm = 120.0;
+        double ppq = 0.0;
+        int64_t timeInSamples = 0;
+        int numerator = 4, denominator = 4;
+
+        bool isRamping = false;
+        double rampStart = 0.0;
+        static constexpr double rampLength = 0.3, rampToBpm = 160.0;
+        double rampFromBpm = 120.0;
+
+        bool isLooping = false;
+        double loopStart = 0.0, loopEnd = 0.0;
+
+        PositionInfo info;
+    };
+
+    //==============================================================================
+    // Receives what the plugin sends and, for each update, how long after its
+    // position was true it arrived
+    class UdpSink : public juce::Thread
+    {
+    public:
+        UdpSink() : juce::Thread("UDP sink")
+        {
+            socket.bindToPort(0, "127.0.0.1");
+        }
+
+        ~UdpSink() override { stopThread(1000); }
+
+        int getPort() const { return socket.getBoundPort(); }
+
+        struct Capture
+        {
+            uint64_t numPackets = 0;
+            uint64_t numBytes = 0;
+            std::vector<uint64_t> latenciesNs;
+        };
+
+        // Everything received since the last call
+        Capture take()
+        {
+            Capture result;
+            const std::lock_guard<std::mutex> sl(lock);
+            std::swap(result, capture);
+            return result;
+        }
+
+        void run() override
+        {
+            char buffer[2048];
+            juce::String senderIP;
+            int senderPort = 0;
+
+            while (!threadShouldExit())
+            {
+                if (socket.waitUntilReady(true, 50) != 1)
+                    continue;
+
+                const int size = socket.read(buffer, (int) sizeof(buffer), false, senderIP, senderPort);
+                const auto arrivalNs = TransportClock::nowNs();
+
+                if (size <= 0)
+                    continue;
+
+                uint64_t positionNs = 0;
+                const bool hasTime = getTimestamp(buffer, (size_t) size, positionNs);
+
+                const std::lock_guard<std::mutex> sl(lock);
+                ++capture.numPackets;
+                capture.numBytes += (uint64_t) size;
+
+                if (hasTime)
+                    capture.latenciesNs.push_back(arrivalNs > positionNs ? arrivalNs - positionNs : 0);
+            }
+        }
+
+    private:
+        static uint64_t readBigEndian64(const char* p)
+        {
+            uint64_t value = 0;
+
+            for (int i = 0; i < 8; ++i)
+                value = (value << 8) | (uint8_t) p[i];
+
+            return value;
+        }
+
+        static size_t paddedLength(const char* s, size_t available)
+        {
+            const auto length = ::strnlen(s, available);
+            return length < available ? (length + 4) & ~(size_t) 3 : available + 1;
+        }
+
+        // The bundle timetag, the binary packet's host time, or a plain /timestamp message
+        static bool getTimestamp(const char* data, size_t size, uint64_t& ns)
+        {
+            if (size >= 16 && std::memcmp(data, "#bundle", 8) == 0)
+            {
+                ns = TransportClock::timeTagToNs(readBigEndian64(data + 8));
+                return true;
+            }
+
+            BinaryTransportPacket packet;
+
+            if (BinaryTransportPacket::decode(data, size, packet))
+            {
+                ns = packet.hostTimeNs;
+                return true;
+            }
+
+            const auto addressLength = paddedLength(data, size);
+
+            if (addressLength + 12 > size || !juce::String(data).endsWith("/timestamp"))
+                return false;
+
+            ns = readBigEndian64(data + addressLength + 4); // After ",ii\0"
+            return true;
+        }
+
+        juce::DatagramSocket socket;
+        std::mutex lock;
+        Capture capture;
+    };
+
+    //==============================================================================
+    struct Percentiles
+    {
+        uint64_t p50 = 0, p99 = 0, max = 0;
+    };
+
+    Percentiles getPercentiles(std::vector<uint64_t>& values)
+    {
+        if (values.empty())
+            return {};
+
+        std::sort(values.begin(), values.end());
+        const auto at = [&](double p) { return values[std::min(values.size() - 1, (size_t) (p * (double) values.size()))]; };
+        return { at(0.50), at(0.99), values.back() };
+    }
+
+    // The plugin reports once a second; this folds the reports seen during a run together
+    struct WireLatency
+    {
+        uint64_t count = 0;
+        double totalNs = 0.0;
+        uint64_t worstP99Ns = 0;
+        uint64_t maxNs = 0;
+
+        void add(const LatencyHistogram::Summary& s)
+        {
+            count += s.count;
+            totalNs += (double) s.meanNs * (double) s.count;
+            worstP99Ns = std::max(worstP99Ns, s.p99Ns);
+            maxNs = std::max(maxNs, s.maxNs);
+        }
+    };
+
+    struct RunResult
+    {
+        bool linkUp = false;
+        uint64_t numBlocks = 0;
+        Percentiles blockNs;
+        double worstLoadPercent = 0.0;
+        uint64_t violations[4] {};
+        WireLatency wire;
+        Percentiles endToEndNs;
+        UdpSink::Capture capture;
+    };
+
+    void sleepUntil(uint64_t targetNs)
+    {
+        // Sleep most of the way, then yield: a plain sleep overshoots small blocks
+        constexpr uint64_t spinNs = 200000;
+        auto now = TransportClock::nowNs();
+
+        if (targetNs > now + spinNs)
+            std::this_thread::sleep_for(std::chrono::nanoseconds(targetNs - now - spinNs));
+
+        while (TransportClock::nowNs() < targetNs)
+            std::this_thread::yield();
+    }
+
+    uint64_t getViolations(RealtimeSafety::ViolationKind kind) { return RealtimeSafety::getNumViolations(kind); }
+
+    // A gate that can't see an allocation passes everything. One block that
+    // allocates must be counted; one doing the sender's real per-update work
+    // must not be.
+    int runSelfTest()
+    {
+        using Kind = RealtimeSafety::ViolationKind;
+
+        if (std::getenv("TRANSPORT_REALTIME_CHECKS_FATAL") != nullptr)
+        {
+            std::fprintf(stderr, "--self-test can't run with TRANSPORT_REALTIME_CHECKS_FATAL set\n");
+            return 1;
+        }
+
+        const auto allocationsBefore = getViolations(Kind::allocation);
+
+        {
+            const RealtimeSafety::ScopedAudioThread audioThread("self-test: allocating block");
+            ::operator delete(::operator new(64)); // A plain call, which the compiler can't elide
+        }
+
+        const auto allocations = getViolations(Kind::allocation) - allocationsBefore;
+
+        OSCTransportEncoder encoder;
+        OSCTransportMessage msg;
+        msg.isPlaying = true;
+        const auto violationsBefore = RealtimeSafety::getNumViolations();
+
+        {
+            const RealtimeSafety::ScopedAudioThread audioThread("self-test: clean block");
+
+            for (int i = 0; i < 64; ++i)
+            {
+                msg.position = i * 0.25;
+                encoder.encodeBundle(msg);
+            }
+        }
+
+        const auto cleanViolations = RealtimeSafety::getNumViolations() - violationsBefore;
+
+        std::printf("allocating block: %llu allocation(s), expected 1\n", (unsigned long long) allocations);
+        std::printf("clean block:      %llu violation(s), expected 0\n", (unsigned long long) cleanViolations);
+
+        const bool passed = allocations == 1 && cleanViolations == 0;
+        std::printf(passed ? "OK\n" : "FAILED\n");
+        return passed ? 0 : 1;
+    }
+
+    RunResult runOnce(const Options& options, double sampleRate, int blockSize, UdpSink& sink)
+    {
+        using Kind = RealtimeSafety::ViolationKind;
+        constexpr Kind kinds[] = { Kind::allocation, Kind::deallocation, Kind::lock, Kind::blockingCall };
+
+        RunResult result;
+        TransportSenderV1AudioProcessor processor;
+        processor.setOscDestinations(juce::StringArray("127.0.0.1:" + juce::String(sink.getPort())));
+        processor.setUseOscBundles(options.format == Format::bundle);
+        processor.setUseBinaryWireFormat(options.format == Format::binary);
+        processor.setMidiClockEnabled(true);
+
+        // The connection manager brings the link up in the background
+        for (int i = 0; i < 200 && !result.linkUp; ++i)
+        {
+            result.linkUp = processor.getOscLinkState() == OSCDestinationSet::LinkState::connected;
+
+            if (!result.linkUp)
+                juce::Thread::sleep(10);
+        }
+
+        ScriptedPlayHead playHead(sampleRate, options.seconds);
+        processor.setPlayHead(&playHead);
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        const int numChannels = std::max({ 1, processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels() });
+        juce::AudioBuffer<float> buffer(numChannels, blockSize);
+        juce::MidiBuffer midi;
+        midi.ensureSize(4096);
+
+        result.numBlocks = (uint64_t) std::ceil(options.seconds * sampleRate / blockSize);
+        const double blockDurationNs = blockSize / sampleRate * 1.0e9;
+        std::vector<uint64_t> blockNs;
+        blockNs.reserve((size_t) result.numBlocks);
+
+        uint64_t violationsBefore[4];
+
+        for (size_t i = 0; i < std::size(kinds); ++i)
+            violationsBefore[i] = getViolations(kinds[i]);
+
+        uint64_t reportVersion = processor.getTelemetryReportVersion();
+        sink.take(); // Anything from before the run
+
+        const auto startNs = TransportClock::nowNs();
+
+        for (uint64_t block = 0; block < result.numBlocks; ++block)
+        {
+            const auto blockStartNs = startNs + (uint64_t) ((double) block * blockDurationNs);
+
+            // A real device hands over a block once its audio has arrived
+            if (!options.fast)
+                sleepUntil(blockStartNs + (uint64_t) blockDurationNs);
+
+            playHead.beginBlock(blockStartNs);
+            midi.clear();
+
+            const auto processStartNs = TransportClock::nowNs();
+            processor.processBlock(buffer, midi);
+            blockNs.push_back(TransportClock::nowNs() - processStartNs);
+
+            playHead.endBlock(blockSize);
+
+            if (processor.getTelemetryReportVersion() != reportVersion)
+            {
+                reportVersion = processor.getTelemetryReportVersion();
+                result.wire.add(processor.getTelemetryReport().wireLatency);
+            }
+        }
+
+        juce::Thread::sleep(100); // Let the last updates arrive
+        result.capture = sink.take();
+
+        processor.releaseResources(); // Lists any realtime violations on stderr
+        processor.setPlayHead(nullptr);
+
+        for (size_t i = 0; i < std::size(kinds); ++i)
+            result.violations[i] = getViolations(kinds[i]) - violationsBefore[i];
+
+        result.blockNs = getPercentiles(blockNs);
+        result.worstLoadPercent = 100.0 * (double) result.blockNs.max / blockDurationNs;
+
+        if (!options.fast)
+            result.endToEndNs = getPercentiles(result.capture.latenciesNs);
+
+        return result;
+    }
+
+    //==============================================================================
+    bool parseOptions(const juce::ArgumentList& args, Options& options)
+    {
+        if (args.containsOption("--help|-h"))
+            return false;
+
+        if (args.containsOption("--rates"))
+        {
+            options.sampleRates.clear();
+
+            for (auto& rate : juce::StringArray::fromTokens(args.getValueForOption("--rates"), ",", ""))
+                if (rate.getDoubleValue() > 0.0)
+                    options.sampleRates.add(rate.getDoubleValue());
+        }
+
+        if (args.containsOption("--blocks"))
+        {
+            options.blockSizes.clear();
+
+            for (auto& size : juce::StringArray::fromTokens(args.getValueForOption("--blocks"), ",", ""))
+                if (size.getIntValue() > 0)
+                    options.blockSizes.add(size.getIntValue());
+        }
+
+        if (args.containsOption("--seconds"))
+            options.seconds = args.getValueForOption("--seconds").getDoubleValue();
+
+        if (args.containsOption("--max-load"))
+            options.maxLoadPercent = args.getValueForOption("--max-load").getDoubleValue();
+
+        if (args.containsOption("--format"))
+        {
+            const auto format = args.getValueForOption("--format");
+
+            if (format == "bundle")         options.format = Format::bundle;
+            else if (format == "messages")  options.format = Format::messages;
+            else if (format == "binary")    options.format = Format::binary;
+            else                            return false;
+        }
+
+        options.fast = args.containsOption("--fast");
+        options.selfTest = args.containsOption("--self-test");
+
+        if (args.containsOption("--encoder-benchmark"))
+        {
+            const auto iterations = args.getValueForOption("--encoder-benchmark").getIntValue();
+            options.benchmarkIterations = iterations > 0 ? iterations : 100000;
+        }
+
+        return options.seconds > 0.0 && !options.sampleRates.isEmpty() && !options.blockSizes.isEmpty();
+    }
+
+    void printUsage()
+    {
+        std::printf("usage: HostSimulator [--rates=44100,48000,96000] [--blocks=16,64,256,1024,4096]\n"
+                    "                     [--seconds=4] [--fast] [--format=bundle|messages|binary] [--max-load=percent]\n"
+                    "       HostSimulator --encoder-benchmark[=iterations]\n"
+                    "       HostSimulator --self-test\n");
+    }
+
+    double toMicroseconds(uint64_t ns) { return (double) ns / 1000.0; }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    Options options;
+
+    if (!parseOptions(juce::ArgumentList(argc, argv), options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    if (options.selfTest)
+        return runSelfTest();
+
+    if (options.benchmarkIterations > 0)
+        return EncoderBenchmark::run(options.benchmarkIterations);
+
+    UdpSink sink;
+
+    if (sink.getPort() <= 0)
+    {
+        std::fprintf(stderr, "can't bind the UDP sink\n");
+        return 1;
+    }
+
+    sink.startThread();
+
+    std::printf("%6s %5s %7s | %23s %7s | %5s %5s %5s %5s | %20s | %20s | %8s %8s\n",
+                "rate", "block", "blocks", "block us p50/p99/max", "load%", "alloc", "free", "lock", "wait",
+                "wire us mean/p99/max", "e2e us p50/p99/max", "packets", "pkt/s");
+
+    bool failed = false;
+
+    for (auto sampleRate : options.sampleRates)
+    {
+        for (auto blockSize : options.blockSizes)
+        {
+            auto r = runOnce(options, sampleRate, blockSize, sink);
+
+            const auto wireMeanNs = r.wire.count > 0 ? (uint64_t) (r.wire.totalNs / (double) r.wire.count) : 0;
+            const auto e2e = options.fast ? juce::String("-")
+                                          : juce::String::formatted("%.0f/%.0f/%.0f", toMicroseconds(r.endToEndNs.p50),
+                                                                    toMicroseconds(r.endToEndNs.p99), toMicroseconds(r.endToEndNs.max));
+
+            std::printf("%6.0f %5d %7llu | %7.1f %7.1f %7.1f %7.2f | %5llu %5llu %5llu %5llu | %6.0f %6.0f %6.0f | %20s | %8llu %8.1f%s\n",
+                        sampleRate, blockSize, (unsigned long long) r.numBlocks,
+                        toMicroseconds(r.blockNs.p50), toMicroseconds(r.blockNs.p99), toMicroseconds(r.blockNs.max), r.worstLoadPercent,
+                        (unsigned long long) r.violations[0], (unsigned long long) r.violations[1],
+                        (unsigned long long) r.violations[2], (unsigned long long) r.violations[3],
+                        toMicroseconds(wireMeanNs), toMicroseconds(r.wire.worstP99Ns), toMicroseconds(r.wire.maxNs),
+                        e2e.toRawUTF8(), (unsigned long long) r.capture.numPackets, r.capture.numPackets / options.seconds,
+                        r.linkUp ? "" : "  (link never came up)");
+
+            const bool anyViolations = r.violations[0] + r.violations[1] + r.violations[2] + r.violations[3] > 0;
+            const bool overLoad = options.maxLoadPercent > 0.0 && r.worstLoadPercent > options.maxLoadPercent;
+            failed = failed || anyViolations || overLoad || r.capture.numPackets == 0;
+        }
+    }
+
+    std::printf(failed ? "FAILED\n" : "OK\n");
+    return failed ? 1 : 0;
+}
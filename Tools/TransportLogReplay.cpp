@@ -0,0 +1,297 @@
+/*
+    TransportLogReplay: sends a recorded TransportLog (.tslog) back out.
+
+    Every record goes out the way the plugin would have sent it, in the
+    chosen wire format, either at the original pace, scaled by --speed, or
+    as fast as the socket takes it (--speed 0). Timestamps are moved onto the
+    replay's own clock (and squeezed by the same factor), so receivers see a
+    coherent stream; --original-timestamps sends them untouched. Context
+    messages go out whenever the context changes and once a second of replay
+    time, as the plugin does.
+
+    Useful for deterministic load tests of receivers and as regression input:
+    the same log always produces the same packets. Pair it with
+    TransportLoopbackRig to see what a receiver makes of a recorded show.
+
+    POSIX only, no JUCE. From the repository root:
+
+        g++ -std=c++17 -O2 -ISource Tools/TransportLogReplay.cpp -o transport-log-replay
+
+    Examples:
+
+        transport-log-replay show.tslog
+        transport-log-replay show.tslog --to 192.168.1.20:9000 --speed 4
+        transport-log-replay show.tslog --speed 0 --format binary --repeat 100
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netdb.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#include "BinaryTransportPacket.h"
+#include "OSCTransportEncoder.h"
+#include "TransportClock.h"
+#include "TransportLog.h"
+
+namespace
+{
+    struct Options
+    {
+        std::string path;
+        std::string host = "127.0.0.1";
+        std::string port = "8000";
+        double speed = 1.0;         // 0 = as fast as possible
+        std::string format = "bundle";
+        std::string prefix;
+        int streamId = -1;          // -1 = every stream in the log
+        int repeat = 1;
+        bool originalTimestamps = false;
+    };
+
+    void printUsage()
+    {
+        std::printf("usage: transport-log-replay LOG [options]\n"
+                    "  --to HOST:PORT          destination (127.0.0.1:8000)\n"
+                    "  --speed X               1 = original pace, 4 = four times faster, 0 = as fast as possible\n"
+                    "  --format F              bundle, messages or binary (bundle)\n"
+                    "  --prefix /NAME          address prefix for OSC formats\n"
+                    "  --stream N              only replay stream N\n"
+                    "  --repeat N              play the log N times\n"
+                    "  --original-timestamps   don't move timestamps onto the replay clock\n");
+    }
+
+    bool parseOptions(int argc, char** argv, Options& o)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+
+            if (arg == "--original-timestamps")     { o.originalTimestamps = true; continue; }
+            if (arg == "--help" || arg == "-h")     return false;
+
+            if (arg.rfind("--", 0) != 0)
+            {
+                o.path = arg;
+                continue;
+            }
+
+            if (i + 1 >= argc)
+                return false;
+
+            const std::string value = argv[++i];
+
+            if      (arg == "--speed")      o.speed = std::atof(value.c_str());
+            else if (arg == "--format")     o.format = value;
+            else if (arg == "--prefix")     o.prefix = value;
+            else if (arg == "--stream")     o.streamId = std::atoi(value.c_str());
+            else if (arg == "--repeat")     o.repeat = std::atoi(value.c_str());
+            else if (arg == "--to")
+            {
+                const auto colon = value.rfind(':');
+
+                if (colon == std::string::npos)
+                    return false;
+
+                o.host = value.substr(0, colon);
+                o.port = value.substr(colon + 1);
+            }
+            else
+            {
+                std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+                return false;
+            }
+        }
+
+        return !o.path.empty() && o.speed >= 0.0 && o.repeat > 0
+            && (o.format == "bundle" || o.format == "messages" || o.format == "binary");
+    }
+
+    class Sender
+    {
+    public:
+        ~Sender()
+        {
+            if (socketHandle >= 0)
+                ::close(socketHandle);
+        }
+
+        bool open(const Options& options)
+        {
+            addrinfo hints {};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_DGRAM;
+            addrinfo* result = nullptr;
+
+            if (::getaddrinfo(options.host.c_str(), options.port.c_str(), &hints, &result) != 0 || result == nullptr)
+                return false;
+
+            std::memcpy(&destination, result->ai_addr, result->ai_addrlen);
+            destinationLength = result->ai_addrlen;
+            socketHandle = ::socket(result->ai_family, SOCK_DGRAM, 0);
+            ::freeaddrinfo(result);
+
+            format = options.format;
+            encoder.setAddressPrefix(options.prefix.c_str());
+            return socketHandle >= 0;
+        }
+
+        void send(const OSCTransportMessage& msg, bool includeContext)
+        {
+            if (format == "binary")
+            {
+                BinaryTransportPacket packet;
+                packet.flags = msg.isPlaying ? BinaryTransportPacket::isPlayingFlag : 0;
+                packet.sequence = sequence++;
+                packet.tickPosition = BinaryTransportPacket::ppqToTicks(msg.position);
+                packet.tempo = msg.tempo;
+                packet.hostTimeNs = msg.hostTimeNs;
+
+                if (includeContext)
+                    packet.setContext(msg.context);
+
+                uint8_t buffer[BinaryTransportPacket::sizeWithContext];
+                packet.encode(buffer);
+                sendBytes(buffer, packet.getEncodedSize());
+                return;
+            }
+
+            if (format == "bundle")
+            {
+                const auto& bundle = encoder.encodeBundle(msg, includeContext);
+                sendBytes(bundle.getData(), bundle.getSize());
+                return;
+            }
+
+            if (includeContext)
+                for (auto field : OSCTransportEncoder::contextFields)
+                    sendMessage(field, msg);
+
+            for (auto field : OSCTransportEncoder::allFields)
+                sendMessage(field, msg);
+        }
+
+        uint64_t getNumPackets() const noexcept     { return numPackets; }
+        uint64_t getNumFailures() const noexcept    { return numFailures; }
+
+    private:
+        void sendMessage(OSCTransportEncoder::Field field, const OSCTransportMessage& msg)
+        {
+            const auto& message = encoder.encodeMessage(field, msg);
+            sendBytes(message.getData(), message.getSize());
+        }
+
+        void sendBytes(const void* data, size_t size)
+        {
+            const auto sent = ::sendto(socketHandle, data, size, 0, reinterpret_cast<const sockaddr*>(&destination), destinationLength);
+            ++(sent == static_cast<ssize_t>(size) ? numPackets : numFailures);
+        }
+
+        int socketHandle = -1;
+        sockaddr_storage destination {};
+        socklen_t destinationLength = 0;
+        std::string format;
+        OSCTransportEncoder encoder;
+        uint32_t sequence = 0;
+        uint64_t numPackets = 0, numFailures = 0;
+    };
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    TransportLog::Reader log;
+
+    if (!log.open(options.path.c_str()))
+    {
+        std::fprintf(stderr, "%s is not a transport log\n", options.path.c_str());
+        return 1;
+    }
+
+    Sender sender;
+
+    if (!sender.open(options))
+    {
+        std::fprintf(stderr, "can't send to %s:%s\n", options.host.c_str(), options.port.c_str());
+        return 1;
+    }
+
+    TransportLog::Record first;
+
+    if (!log.read(0, first))
+    {
+        std::fprintf(stderr, "%s has no records\n", options.path.c_str());
+        return 1;
+    }
+
+    std::printf("replaying %zu records from %s to %s:%s at %s\n", log.getNumRecords(), options.path.c_str(),
+                options.host.c_str(), options.port.c_str(),
+                options.speed > 0.0 ? (std::to_string(options.speed) + "x").c_str() : "full speed");
+
+    static constexpr uint64_t contextKeyframeIntervalNs = 1000000000;
+    const auto startNs = TransportClock::nowNs();
+    uint64_t numReplayed = 0;
+
+    for (int pass = 0; pass < options.repeat; ++pass)
+    {
+        const auto passStartNs = TransportClock::nowNs();
+        TransportContext lastContext;
+        uint64_t lastContextNs = 0;
+        bool hasSentContext = false;
+        TransportLog::Record record;
+
+        for (size_t i = 0; i < log.getNumRecords() && log.read(i, record); ++i)
+        {
+            if (options.streamId >= 0 && record.streamId != options.streamId)
+                continue;
+
+            // Where this record falls on the replay clock
+            auto& msg = record.message;
+            const double elapsed = static_cast<double>(static_cast<int64_t>(record.sentNs - first.sentNs));
+            uint64_t dueNs = TransportClock::nowNs();
+
+            if (options.speed > 0.0)
+            {
+                dueNs = passStartNs + static_cast<uint64_t>(std::max(0.0, elapsed / options.speed));
+                std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(dueNs)));
+            }
+
+            if (!options.originalTimestamps)
+            {
+                // Keep each update's lead or lag relative to when it was sent
+                const double lead = static_cast<double>(static_cast<int64_t>(msg.hostTimeNs - record.sentNs));
+                msg.hostTimeNs = dueNs + static_cast<uint64_t>(static_cast<int64_t>(options.speed > 0.0 ? lead / options.speed : 0.0));
+            }
+
+            const bool includeContext = !hasSentContext || msg.context != lastContext || dueNs - lastContextNs >= contextKeyframeIntervalNs;
+
+            if (includeContext)
+            {
+                lastContext = msg.context;
+                lastContextNs = dueNs;
+                hasSentContext = true;
+            }
+
+            sender.send(msg, includeContext);
+            ++numReplayed;
+        }
+    }
+
+    const double seconds = (TransportClock::nowNs() - startNs) * 1.0e-9;
+    std::printf("sent %llu updates in %llu packets (%llu failed) over %.3f s, %.0f updates/s\n",
+                (unsigned long long) numReplayed, (unsigned long long) sender.getNumPackets(),
+                (unsigned long long) sender.getNumFailures(), seconds, seconds > 0.0 ? numReplayed / seconds : 0.0);
+    return 0;
+}
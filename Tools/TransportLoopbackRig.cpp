@@ -0,0 +1,916 @@
+/*
+    TransportLoopbackRig: measures what a receiver of TransportSender actually gets.
+
+    Binds the port the plugin sends to, timestamps every arrival and rebuilds
+    the sent timeline from /play, /tempo, /position and /timestamp (bundled or
+    not) or from binary packets. It reports:
+
+      - latency        arrival time minus the update's own timestamp, p50/p99/p99.9
+      - jitter         RFC 3550 inter-arrival jitter, and p99 of the per-packet variation
+      - position error what a receiver would be showing just before each update
+                       arrives, against the true position at that moment, for
+                       both TransportExtrapolator and TransportPhaseTracker
+      - reordering     updates that arrive after a newer one, and binary sequence gaps
+
+    Latency is only meaningful when the sender's timestamps share our clock:
+    same machine, and the plugin stamping with TransportClock (the host gave
+    no host time). With --drive the rig plays host itself: a thread runs
+    blocks in real time through TransportRateController and the shared
+    encoders, exactly as processBlock does, and sends to the rig over
+    loopback. Its timeline is known exactly, so position errors are measured
+    against the true ppq rather than against the next packet.
+
+    Between the socket and the analysis an impairment stage can drop, delay,
+    jitter and reorder packets; --forward passes the impaired stream on to a
+    real receiver as well.
+
+    Linux/POSIX only, no JUCE. From the repository root:
+
+        g++ -std=c++17 -O2 -pthread -ISource Tools/TransportLoopbackRig.cpp -o transport-loopback-rig
+
+    Examples:
+
+        transport-loopback-rig --drive 120 --ramp-to 140 --ramp-seconds 4 --duration 30
+        transport-loopback-rig --drive 120 --ramp-to 140 --ramp-seconds 4 --duration 30 --fixed-rate 30
+        transport-loopback-rig --drive 128 --loss 2 --jitter 3 --reorder 1 --format binary
+        transport-loopback-rig --port 8000 --forward 127.0.0.1:8001 --delay 5
+        transport-loopback-rig --drive 120 --group 239.255.0.1 --interface 127.0.0.1
+*/
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <netdb.h>
+#include <poll.h>
+#include <random>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "BinaryTransportPacket.h"
+#include "OSCTransportEncoder.h"
+#include "TransportClock.h"
+#include "TransportExtrapolator.h"
+#include "TransportPhaseTracker.h"
+#include "TransportRateController.h"
+
+namespace
+{
+    std::atomic<bool> shouldExit { false };
+
+    void handleSignal(int)      { shouldExit = true; }
+
+    struct Options
+    {
+        int port = 8000;
+        std::string forwardHost;
+        int forwardPort = 0;
+        std::string group;          // Multicast group to join; --drive sends to it
+        std::string interfaceAddress;
+
+        double lossPercent = 0.0;
+        double delayMs = 0.0;
+        double jitterMs = 0.0;      // Uniform extra delay in [0, jitter); reorders packets closer than that
+        double reorderPercent = 0.0;
+        double reorderDelayMs = 20.0;
+        unsigned seed = 1;
+
+        double durationSeconds = 0.0; // 0 = until Ctrl-C
+        double reportSeconds = 5.0;
+        std::string csvPath;
+
+        // --drive
+        bool drive = false;
+        double bpm = 120.0;
+        double rampToBpm = 0.0;
+        double rampSeconds = 4.0;
+        double loopBeats = 0.0;
+        double sampleRate = 48000.0;
+        int blockSize = 256;
+        std::string format = "bundle";
+        double fixedRateHz = 0.0;   // The old fixed-interval scheme instead of rate control; 0 = off
+    };
+
+    //==============================================================================
+    // The driver's host timeline, shared with the analyzer as ground truth.
+    // Tempo sweeps linearly between bpm and rampToBpm and back, every
+    // rampSeconds, so rate control is exercised continuously.
+    struct HostTimeline
+    {
+        uint64_t startNs = 0;
+        double bpm = 120.0;
+        double rampToBpm = 120.0;
+        double rampSeconds = 4.0;
+        double loopBeats = 0.0;
+
+        double bpmAt(double seconds) const noexcept
+        {
+            if (rampToBpm == bpm || rampSeconds <= 0.0)
+                return bpm;
+
+            const double u = std::fmod(seconds, 2.0 * rampSeconds);
+            const double ramp = u <= rampSeconds ? u / rampSeconds : 2.0 - u / rampSeconds;
+            return bpm + (rampToBpm - bpm) * ramp;
+        }
+
+        // Integral of the tempo curve, in beats
+        double unloopedPpqAt(double seconds) const noexcept
+        {
+            if (rampToBpm == bpm || rampSeconds <= 0.0)
+                return seconds * bpm / 60.0;
+
+            const double T = rampSeconds, d = rampToBpm - bpm;
+            const double periods = std::floor(seconds / (2.0 * T));
+            const double u = seconds - periods * 2.0 * T;
+            double beatMinutes = periods * (2.0 * bpm * T + d * T) + bpm * u;
+
+            if (u <= T)
+                beatMinutes += d * u * u / (2.0 * T);
+            else
+                beatMinutes += d * T / 2.0 + d * ((u - T) - (u - T) * (u - T) / (2.0 * T));
+
+            return beatMinutes / 60.0;
+        }
+
+        double ppqAt(double seconds) const noexcept
+        {
+            const double ppq = unloopedPpqAt(seconds);
+            return loopBeats > 0.0 ? std::fmod(ppq, loopBeats) : ppq;
+        }
+
+        double secondsAt(uint64_t ns) const noexcept
+        {
+            return ns > startNs ? (ns - startNs) * 1.0e-9 : 0.0;
+        }
+    };
+
+    //==============================================================================
+    // One decoded transport update
+    struct Update
+    {
+        bool isPlaying = false;
+        double bpm = 0.0;
+        double ppq = 0.0;
+        uint64_t hostTimeNs = 0;
+        bool hasSequence = false;
+        uint32_t sequence = 0;
+    };
+
+    // Reads the plugin's OSC output. Prefixed addresses ("/deck2/play") are
+    // matched on their last component; /stats, /ping and anything else is skipped.
+    class OscTransportParser
+    {
+    public:
+        // Calls `onUpdate` for each complete update in the datagram
+        template <typename Callback>
+        void parse(const char* data, size_t size, Callback&& onUpdate)
+        {
+            if (size >= 16 && std::memcmp(data, "#bundle", 8) == 0)
+            {
+                pending = {};
+                pendingFields = 0;
+                pending.hostTimeNs = TransportClock::timeTagToNs(readUInt64(data + 8));
+
+                for (size_t pos = 16; pos + 4 <= size;)
+                {
+                    const auto elementSize = readUInt32(data + pos);
+                    pos += 4;
+
+                    if (elementSize > size - pos)
+                        break;
+
+                    parseMessage(data + pos, elementSize);
+                    pos += elementSize;
+                }
+
+                if ((pendingFields & positionField) != 0)
+                    onUpdate(pending);
+            }
+            else if (parseMessage(data, size) == timestampField && (pendingFields & positionField) != 0)
+            {
+                // Individual messages: /timestamp closes each update
+                onUpdate(pending);
+                pendingFields = 0;
+            }
+        }
+
+    private:
+        enum { playField = 1, tempoField = 2, positionField = 4, timestampField = 8 };
+
+        static uint32_t readUInt32(const char* p) noexcept
+        {
+            const auto* u = reinterpret_cast<const uint8_t*>(p);
+            return (uint32_t(u[0]) << 24) | (uint32_t(u[1]) << 16) | (uint32_t(u[2]) << 8) | uint32_t(u[3]);
+        }
+
+        static uint64_t readUInt64(const char* p) noexcept   { return (uint64_t(readUInt32(p)) << 32) | readUInt32(p + 4); }
+
+        static float readFloat(const char* p) noexcept
+        {
+            const auto bits = readUInt32(p);
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        // Length of the padded OSC string at p, or 0 if it runs off the end
+        static size_t paddedLength(const char* p, size_t available) noexcept
+        {
+            const auto* end = static_cast<const char*>(std::memchr(p, 0, available));
+            return end != nullptr ? std::min(available, ((size_t) (end - p) + 4) & ~size_t(3)) : 0;
+        }
+
+        static bool endsWith(const char* text, const char* suffix) noexcept
+        {
+            const auto textLength = std::strlen(text), suffixLength = std::strlen(suffix);
+            return textLength >= suffixLength && std::strcmp(text + textLength - suffixLength, suffix) == 0;
+        }
+
+        int parseMessage(const char* data, size_t size)
+        {
+            const auto addressLength = paddedLength(data, size);
+
+            if (addressLength == 0 || data[0] != '/')
+                return 0;
+
+            const auto tagsLength = paddedLength(data + addressLength, size - addressLength);
+
+            if (tagsLength == 0)
+                return 0;
+
+            const char* address = data;
+            const char* tags = data + addressLength;
+            const char* args = tags + tagsLength;
+            const size_t argsSize = size - addressLength - tagsLength;
+
+            if (endsWith(address, "/play") && std::strcmp(tags, ",i") == 0 && argsSize >= 4)
+            {
+                pending.isPlaying = readUInt32(args) != 0;
+                pendingFields |= playField;
+                return playField;
+            }
+
+            if (endsWith(address, "/tempo") && std::strcmp(tags, ",f") == 0 && argsSize >= 4)
+            {
+                pending.bpm = readFloat(args);
+                pendingFields |= tempoField;
+                return tempoField;
+            }
+
+            if (endsWith(address, "/position") && std::strcmp(tags, ",f") == 0 && argsSize >= 4)
+            {
+                pending.ppq = readFloat(args);
+                pendingFields |= positionField;
+                return positionField;
+            }
+
+            if (endsWith(address, "/timestamp") && std::strcmp(tags, ",ii") == 0 && argsSize >= 8)
+            {
+                pending.hostTimeNs = TransportClock::fromWords(static_cast<int32_t>(readUInt32(args)),
+                                                               static_cast<int32_t>(readUInt32(args + 4)));
+                pendingFields |= timestampField;
+                return timestampField;
+            }
+
+            return 0;
+        }
+
+        Update pending;
+        int pendingFields = 0;
+    };
+
+    //==============================================================================
+    // Drops, delays and reorders datagrams before they reach the analyzer
+    class Impairment
+    {
+    public:
+        explicit Impairment(const Options& o) : options(o), random(o.seed) {}
+
+        void push(const char* data, size_t size, uint64_t arrivalNs)
+        {
+            if (chance(options.lossPercent))
+            {
+                ++numDropped;
+                return;
+            }
+
+            double delayMs = options.delayMs;
+
+            if (options.jitterMs > 0.0)
+                delayMs += std::uniform_real_distribution<double>(0.0, options.jitterMs)(random);
+
+            if (chance(options.reorderPercent))
+                delayMs += options.reorderDelayMs;
+
+            const auto releaseNs = arrivalNs + static_cast<uint64_t>(delayMs * 1.0e6);
+            queue.emplace(releaseNs, std::string(data, size));
+        }
+
+        // Packets due by `nowNs`, in release order, with the time each was due
+        template <typename Callback>
+        void release(uint64_t nowNs, Callback&& onPacket)
+        {
+            while (!queue.empty() && queue.begin()->first <= nowNs)
+            {
+                auto packet = queue.begin();
+                onPacket(packet->second.data(), packet->second.size(), packet->first);
+                queue.erase(packet);
+            }
+        }
+
+        // Milliseconds until the next packet is due, for poll(); -1 if none is queued
+        int msUntilNext(uint64_t nowNs) const
+        {
+            if (queue.empty())
+                return -1;
+
+            const auto due = queue.begin()->first;
+            return due <= nowNs ? 0 : static_cast<int>((due - nowNs + 999999) / 1000000);
+        }
+
+        uint64_t getNumDropped() const noexcept     { return numDropped; }
+
+    private:
+        bool chance(double percent)
+        {
+            return percent > 0.0 && std::uniform_real_distribution<double>(0.0, 100.0)(random) < percent;
+        }
+
+        const Options& options;
+        std::mt19937 random;
+        std::multimap<uint64_t, std::string> queue; // Stable for equal times, so no spurious reordering
+        uint64_t numDropped = 0;
+    };
+
+    //==============================================================================
+    class Analyzer
+    {
+    public:
+        Analyzer(const HostTimeline* truthToUse, FILE* csvToUse) : truth(truthToUse), csv(csvToUse)
+        {
+            if (csv != nullptr)
+                std::fprintf(csv, "arrival_ns,host_time_ns,playing,bpm,ppq,latency_ms,extrapolator_error_ms,tracker_error_ms,reordered\n");
+        }
+
+        void addUpdate(const Update& update, uint64_t arrivalNs)
+        {
+            ++numUpdates;
+
+            // Anything older than what we already have is late: count it, don't apply it
+            const bool reordered = hasLast && (update.hasSequence ? !BinaryTransportPacket::isNewerSequence(update.sequence, lastSequence)
+                                                                  : update.hostTimeNs < lastHostTimeNs);
+
+            const auto latencyNs = static_cast<int64_t>(arrivalNs - update.hostTimeNs);
+            latencies.push_back(latencyNs);
+
+            if (reordered)
+            {
+                ++numReordered;
+                writeCsv(update, arrivalNs, latencyNs, NAN, NAN, true);
+                return;
+            }
+
+            if (hasLast)
+            {
+                // RFC 3550: variation in transit time between consecutive packets
+                const double d = static_cast<double>(latencyNs - lastLatencyNs);
+                jitterNs += (std::abs(d) - jitterNs) / 16.0;
+                transitVariation.push_back(static_cast<int64_t>(std::abs(d)));
+
+                if (update.hasSequence)
+                    numSequenceGaps += static_cast<uint64_t>(static_cast<uint32_t>(update.sequence - lastSequence) - 1);
+            }
+
+            // What each receiver model was showing just before this update landed
+            double extrapolatorErrorMs = NAN, trackerErrorMs = NAN;
+
+            if (extrapolator.hasPosition() && update.isPlaying && extrapolator.isPlaying())
+            {
+                const double truePpq = truePpqAt(update, arrivalNs);
+                const double msPerBeat = 60000.0 / std::max(update.bpm, 1.0);
+
+                extrapolatorErrorMs = (extrapolator.getPpqAt(arrivalNs) - truePpq) * msPerBeat;
+                trackerErrorMs = (tracker.getPpqAt(arrivalNs) - truePpq) * msPerBeat;
+
+                // Skip loop wraps and locates: they are relocations, not tracking error
+                if (std::abs(extrapolatorErrorMs) < relocationMs)
+                {
+                    extrapolatorErrors.push_back(std::abs(extrapolatorErrorMs));
+                    trackerErrors.push_back(std::abs(trackerErrorMs));
+                }
+            }
+
+            extrapolator.update(update.isPlaying, update.bpm, update.ppq, arrivalNs);
+            tracker.update(update.isPlaying, update.bpm, update.ppq, arrivalNs);
+
+            writeCsv(update, arrivalNs, latencyNs, extrapolatorErrorMs, trackerErrorMs, false);
+
+            hasLast = true;
+            lastHostTimeNs = update.hostTimeNs;
+            lastSequence = update.sequence;
+            lastLatencyNs = latencyNs;
+        }
+
+        void print(double elapsedSeconds, uint64_t impairmentDrops, uint64_t sent) const
+        {
+            std::printf("\n--- %.1f s: %llu updates", elapsedSeconds, (unsigned long long) numUpdates);
+
+            if (sent > 0)
+                std::printf(" of %llu sent", (unsigned long long) sent);
+
+            std::printf(", %llu dropped by impairment, %llu reordered, %llu sequence gaps\n",
+                        (unsigned long long) impairmentDrops, (unsigned long long) numReordered, (unsigned long long) numSequenceGaps);
+
+            printDistribution("latency", latencies, 1.0e-6);
+            std::printf("  %-22s %9.3f ms (RFC 3550)\n", "inter-arrival jitter", jitterNs * 1.0e-6);
+            printDistribution("transit variation", transitVariation, 1.0e-6);
+            printDistribution(truth != nullptr ? "extrapolator error" : "extrapolator error*", extrapolatorErrors, 1.0);
+            printDistribution(truth != nullptr ? "phase tracker error" : "phase tracker error*", trackerErrors, 1.0);
+
+            if (truth == nullptr)
+                std::printf("  * against each update run forward to its arrival; use --drive for the true host position\n");
+
+            std::fflush(stdout);
+        }
+
+    private:
+        static constexpr double relocationMs = 250.0;
+
+        double truePpqAt(const Update& update, uint64_t arrivalNs) const noexcept
+        {
+            if (truth != nullptr)
+                return truth->ppqAt(truth->secondsAt(arrivalNs));
+
+            const double ahead = arrivalNs > update.hostTimeNs ? (arrivalNs - update.hostTimeNs) * 1.0e-9 : 0.0;
+            return update.ppq + ahead * update.bpm / 60.0;
+        }
+
+        template <typename Value>
+        static void printDistribution(const char* name, std::vector<Value> values, double scale)
+        {
+            if (values.empty())
+            {
+                std::printf("  %-22s no samples\n", name);
+                return;
+            }
+
+            std::sort(values.begin(), values.end());
+
+            const auto at = [&](double fraction)
+            {
+                const auto index = std::min(values.size() - 1, static_cast<size_t>(fraction * (values.size() - 1) + 0.5));
+                return static_cast<double>(values[index]) * scale;
+            };
+
+            std::printf("  %-22s p50 %8.3f  p99 %8.3f  p99.9 %8.3f  max %8.3f ms  (n=%zu)\n",
+                        name, at(0.5), at(0.99), at(0.999), at(1.0), values.size());
+        }
+
+        void writeCsv(const Update& u, uint64_t arrivalNs, int64_t latencyNs, double extrapolatorErrorMs, double trackerErrorMs, bool reordered)
+        {
+            if (csv != nullptr)
+                std::fprintf(csv, "%llu,%llu,%d,%.6f,%.6f,%.6f,%.6f,%.6f,%d\n",
+                             (unsigned long long) arrivalNs, (unsigned long long) u.hostTimeNs, u.isPlaying ? 1 : 0,
+                             u.bpm, u.ppq, latencyNs * 1.0e-6, extrapolatorErrorMs, trackerErrorMs, reordered ? 1 : 0);
+        }
+
+        const HostTimeline* truth;
+        FILE* csv;
+
+        TransportExtrapolator extrapolator;
+        TransportPhaseTracker tracker;
+
+        bool hasLast = false;
+        uint64_t lastHostTimeNs = 0;
+        uint32_t lastSequence = 0;
+        int64_t lastLatencyNs = 0;
+        double jitterNs = 0.0;
+
+        uint64_t numUpdates = 0, numReordered = 0, numSequenceGaps = 0;
+        std::vector<int64_t> latencies, transitVariation;
+        std::vector<double> extrapolatorErrors, trackerErrors;
+    };
+
+    //==============================================================================
+    // Plays host: runs blocks in real time and publishes through the same
+    // rate controller and encoders as processBlock. Each block is processed
+    // when its last sample is due, as a capture-driven callback would be, so
+    // every timestamp is in the past when it is sent.
+    class HostDriver
+    {
+    public:
+        HostDriver(const Options& o, const HostTimeline& t, int destinationPort)
+            : options(o), timeline(t)
+        {
+            socketHandle = ::socket(AF_INET, SOCK_DGRAM, 0);
+            destination.sin_family = AF_INET;
+            destination.sin_port = htons(static_cast<uint16_t>(destinationPort));
+            destination.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+            // Through the group instead, looped back to ourselves, as a multicast destination would be
+            if (!o.group.empty() && ::inet_pton(AF_INET, o.group.c_str(), &destination.sin_addr) == 1)
+            {
+                const unsigned char ttl = 1, loopback = 1;
+                in_addr interfaceAddress {};
+                interfaceAddress.s_addr = htonl(INADDR_ANY);
+                ::inet_pton(AF_INET, o.interfaceAddress.c_str(), &interfaceAddress);
+
+                ::setsockopt(socketHandle, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+                ::setsockopt(socketHandle, IPPROTO_IP, IP_MULTICAST_LOOP, &loopback, sizeof(loopback));
+                ::setsockopt(socketHandle, IPPROTO_IP, IP_MULTICAST_IF, &interfaceAddress, sizeof(interfaceAddress));
+            }
+        }
+
+        ~HostDriver()
+        {
+            stop();
+
+            if (socketHandle >= 0)
+                ::close(socketHandle);
+        }
+
+        void start()    { thread = std::thread([this] { run(); }); }
+
+        void stop()
+        {
+            running = false;
+
+            if (thread.joinable())
+                thread.join();
+        }
+
+        uint64_t getNumSent() const noexcept    { return numSent.load(); }
+
+    private:
+        void run()
+        {
+            TransportRateController rateController;
+            OSCTransportEncoder encoder;
+            BinaryTransportPacket packet;
+            uint8_t binary[BinaryTransportPacket::size];
+
+            const double sampleRate = options.sampleRate;
+            const int blockSize = options.blockSize;
+            const double samplesPerMessage = options.fixedRateHz > 0.0 ? sampleRate / options.fixedRateHz : 0.0;
+            double sampleCounter = 0.0;
+
+            for (int64_t block = 0; running; ++block)
+            {
+                const double blockStartSeconds = static_cast<double>(block * blockSize) / sampleRate;
+                const double blockEndSeconds = static_cast<double>((block + 1) * blockSize) / sampleRate;
+                std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+                    std::chrono::nanoseconds(timeline.startNs + static_cast<uint64_t>(blockEndSeconds * 1.0e9))));
+
+                TransportRateController::State state { true, timeline.ppqAt(blockStartSeconds), timeline.bpmAt(blockStartSeconds) };
+                TransportRateController::Reason reason;
+                int offset = -1;
+
+                if (options.fixedRateHz > 0.0)
+                {
+                    // What processBlock did before rate control: the block's start position,
+                    // once every samplesPerMessage samples
+                    sampleCounter += blockSize;
+
+                    if (sampleCounter >= samplesPerMessage)
+                    {
+                        sampleCounter -= samplesPerMessage;
+                        offset = 0;
+                    }
+                }
+                else
+                {
+                    offset = rateController.getSendOffset(state, blockStartSeconds, blockSize, sampleRate, reason);
+                }
+
+                if (offset < 0)
+                    continue;
+
+                const double sendSeconds = blockStartSeconds + offset / sampleRate;
+                state.ppq = timeline.ppqAt(sendSeconds);
+                state.bpm = timeline.bpmAt(sendSeconds);
+                rateController.markSent(state, sendSeconds);
+
+                OSCTransportMessage msg {};
+                msg.isPlaying = true;
+                msg.tempo = state.bpm;
+                msg.position = state.ppq;
+                msg.hostTimeNs = timeline.startNs + static_cast<uint64_t>(sendSeconds * 1.0e9);
+
+                if (options.format == "binary")
+                {
+                    packet.flags = BinaryTransportPacket::isPlayingFlag;
+                    packet.sequence = sequence++;
+                    packet.tickPosition = BinaryTransportPacket::ppqToTicks(msg.position);
+                    packet.tempo = msg.tempo;
+                    packet.hostTimeNs = msg.hostTimeNs;
+                    packet.encode(binary);
+                    send(binary, sizeof(binary));
+                }
+                else if (options.format == "messages")
+                {
+                    for (auto field : OSCTransportEncoder::allFields)
+                    {
+                        const auto& message = encoder.encodeMessage(field, msg);
+                        send(message.getData(), message.getSize());
+                    }
+                }
+                else
+                {
+                    const auto& bundle = encoder.encodeBundle(msg);
+                    send(bundle.getData(), bundle.getSize());
+                }
+
+                ++numSent;
+            }
+        }
+
+        void send(const void* data, size_t size)
+        {
+            ::sendto(socketHandle, data, size, 0, reinterpret_cast<const sockaddr*>(&destination), sizeof(destination));
+        }
+
+        const Options& options;
+        const HostTimeline& timeline;
+        int socketHandle = -1;
+        sockaddr_in destination {};
+        uint32_t sequence = 0;
+
+        std::thread thread;
+        std::atomic<bool> running { true };
+        std::atomic<uint64_t> numSent { 0 };
+    };
+
+    //==============================================================================
+    void printUsage()
+    {
+        std::printf("usage: transport-loopback-rig [options]\n"
+                    "  --port N             port to listen on (8000)\n"
+                    "  --forward HOST:PORT  also pass the impaired stream on\n"
+                    "  --group ADDR         join this multicast group (and --drive through it)\n"
+                    "  --interface ADDR     interface address for the group (OS default)\n"
+                    "  --loss PCT           drop this percentage of packets\n"
+                    "  --delay MS           fixed extra delay\n"
+                    "  --jitter MS          uniform random extra delay up to MS\n"
+                    "  --reorder PCT        hold back this percentage of packets by --reorder-delay MS (20)\n"
+                    "  --seed N             impairment random seed\n"
+                    "  --duration S         stop after S seconds (default: Ctrl-C)\n"
+                    "  --report S           print a report every S seconds (5)\n"
+                    "  --csv FILE           write every update to FILE\n"
+                    "  --drive BPM          run a synthetic host at BPM and measure against it\n"
+                    "  --ramp-to BPM        sweep the driven tempo to BPM and back\n"
+                    "  --ramp-seconds S     length of each sweep (4)\n"
+                    "  --loop-beats N       loop the driven position every N beats\n"
+                    "  --rate HZ --block N  driven sample rate and block size (48000, 256)\n"
+                    "  --format F           driven wire format: bundle, messages or binary\n"
+                    "  --fixed-rate HZ      drive at a fixed HZ, as before rate control, for comparison\n");
+    }
+
+    bool parseOptions(int argc, char** argv, Options& o)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            const char* value = hasValue ? argv[i + 1] : "";
+
+            if (arg == "--help" || arg == "-h")     return false;
+            if (!hasValue)                           { std::fprintf(stderr, "missing value for %s\n", arg.c_str()); return false; }
+
+            ++i;
+
+            if      (arg == "--port")           o.port = std::atoi(value);
+            else if (arg == "--loss")           o.lossPercent = std::atof(value);
+            else if (arg == "--delay")          o.delayMs = std::atof(value);
+            else if (arg == "--jitter")         o.jitterMs = std::atof(value);
+            else if (arg == "--reorder")        o.reorderPercent = std::atof(value);
+            else if (arg == "--reorder-delay")  o.reorderDelayMs = std::atof(value);
+            else if (arg == "--seed")           o.seed = static_cast<unsigned>(std::atoi(value));
+            else if (arg == "--duration")       o.durationSeconds = std::atof(value);
+            else if (arg == "--report")         o.reportSeconds = std::atof(value);
+            else if (arg == "--csv")            o.csvPath = value;
+            else if (arg == "--drive")          { o.drive = true; o.bpm = std::atof(value); }
+            else if (arg == "--ramp-to")        o.rampToBpm = std::atof(value);
+            else if (arg == "--ramp-seconds")   o.rampSeconds = std::atof(value);
+            else if (arg == "--loop-beats")     o.loopBeats = std::atof(value);
+            else if (arg == "--rate")           o.sampleRate = std::atof(value);
+            else if (arg == "--block")          o.blockSize = std::atoi(value);
+            else if (arg == "--format")         o.format = value;
+            else if (arg == "--fixed-rate")     o.fixedRateHz = std::atof(value);
+            else if (arg == "--group")          o.group = value;
+            else if (arg == "--interface")      o.interfaceAddress = value;
+            else if (arg == "--forward")
+            {
+                const std::string target = value;
+                const auto colon = target.rfind(':');
+
+                if (colon == std::string::npos)
+                    return false;
+
+                o.forwardHost = target.substr(0, colon);
+                o.forwardPort = std::atoi(target.c_str() + colon + 1);
+            }
+            else
+            {
+                std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+                return false;
+            }
+        }
+
+        return o.port > 0 && o.blockSize > 0 && o.sampleRate > 0.0 && (!o.drive || o.bpm > 0.0)
+            && (o.format == "bundle" || o.format == "messages" || o.format == "binary");
+    }
+
+    bool resolve(const std::string& host, int port, sockaddr_storage& address, socklen_t& length)
+    {
+        addrinfo hints {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_DGRAM;
+        addrinfo* result = nullptr;
+
+        if (::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0 || result == nullptr)
+            return false;
+
+        std::memcpy(&address, result->ai_addr, result->ai_addrlen);
+        length = result->ai_addrlen;
+        ::freeaddrinfo(result);
+        return true;
+    }
+}
+
+//==============================================================================
+int main(int argc, char** argv)
+{
+    Options options;
+
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    const int listenSocket = ::socket(AF_INET, SOCK_DGRAM, 0);
+    const int reuse = 1;
+    ::setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in local {};
+    local.sin_family = AF_INET;
+    local.sin_port = htons(static_cast<uint16_t>(options.port));
+    local.sin_addr.s_addr = htonl(options.drive && options.group.empty() ? INADDR_LOOPBACK : INADDR_ANY);
+
+    if (listenSocket < 0 || ::bind(listenSocket, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) != 0)
+    {
+        std::fprintf(stderr, "can't bind port %d: %s\n", options.port, std::strerror(errno));
+        return 1;
+    }
+
+    if (!options.group.empty())
+    {
+        ip_mreq request {};
+        request.imr_interface.s_addr = htonl(INADDR_ANY);
+
+        if (::inet_pton(AF_INET, options.group.c_str(), &request.imr_multiaddr) != 1
+            || (!options.interfaceAddress.empty() && ::inet_pton(AF_INET, options.interfaceAddress.c_str(), &request.imr_interface) != 1)
+            || ::setsockopt(listenSocket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &request, sizeof(request)) != 0)
+        {
+            std::fprintf(stderr, "can't join group %s: %s\n", options.group.c_str(), std::strerror(errno));
+            return 1;
+        }
+    }
+
+    sockaddr_storage forwardAddress {};
+    socklen_t forwardLength = 0;
+    int forwardSocket = -1;
+
+    if (options.forwardPort > 0)
+    {
+        if (!resolve(options.forwardHost, options.forwardPort, forwardAddress, forwardLength))
+        {
+            std::fprintf(stderr, "can't resolve %s\n", options.forwardHost.c_str());
+            return 1;
+        }
+
+        forwardSocket = ::socket(forwardAddress.ss_family, SOCK_DGRAM, 0);
+    }
+
+    HostTimeline timeline;
+    timeline.startNs = TransportClock::nowNs();
+    timeline.bpm = options.bpm;
+    timeline.rampToBpm = options.rampToBpm > 0.0 ? options.rampToBpm : options.bpm;
+    timeline.rampSeconds = options.rampSeconds;
+    timeline.loopBeats = options.loopBeats;
+
+    FILE* csv = options.csvPath.empty() ? nullptr : std::fopen(options.csvPath.c_str(), "w");
+    Analyzer analyzer(options.drive ? &timeline : nullptr, csv);
+    Impairment impairment(options);
+    OscTransportParser parser;
+
+    std::unique_ptr<HostDriver> driver;
+
+    if (options.drive)
+    {
+        driver = std::make_unique<HostDriver>(options, timeline, options.port);
+        driver->start();
+    }
+
+    std::printf("listening on port %d%s\n", options.port, options.drive ? ", driving a synthetic host over loopback" : "");
+
+    const auto startNs = TransportClock::nowNs();
+    auto nextReportNs = startNs + static_cast<uint64_t>(options.reportSeconds * 1.0e9);
+    char buffer[65536];
+
+    const auto report = [&](uint64_t nowNs)
+    {
+        analyzer.print((nowNs - startNs) * 1.0e-9, impairment.getNumDropped(), driver != nullptr ? driver->getNumSent() : 0);
+    };
+
+    const auto deliver = [&](const char* data, size_t size, uint64_t arrivalNs)
+    {
+        if (forwardSocket >= 0)
+            ::sendto(forwardSocket, data, size, 0, reinterpret_cast<const sockaddr*>(&forwardAddress), forwardLength);
+
+        BinaryTransportPacket packet;
+
+        if (BinaryTransportPacket::decode(data, size, packet))
+        {
+            Update update { packet.isPlaying(), packet.tempo, packet.getPpqPosition(), packet.hostTimeNs, true, packet.sequence };
+            analyzer.addUpdate(update, arrivalNs);
+            return;
+        }
+
+        parser.parse(data, size, [&](const Update& update) { analyzer.addUpdate(update, arrivalNs); });
+    };
+
+    while (!shouldExit)
+    {
+        auto nowNs = TransportClock::nowNs();
+
+        if (options.durationSeconds > 0.0 && nowNs - startNs >= static_cast<uint64_t>(options.durationSeconds * 1.0e9))
+            break;
+
+        // Sleep until a datagram, a delayed packet, the next report or the end, whichever comes first
+        auto wakeNs = nextReportNs;
+
+        if (options.durationSeconds > 0.0)
+            wakeNs = std::min(wakeNs, startNs + static_cast<uint64_t>(options.durationSeconds * 1.0e9));
+
+        int timeoutMs = static_cast<int>((wakeNs > nowNs ? wakeNs - nowNs + 999999 : 0) / 1000000);
+        const int untilRelease = impairment.msUntilNext(nowNs);
+
+        if (untilRelease >= 0)
+            timeoutMs = std::min(timeoutMs, untilRelease);
+
+        pollfd fd { listenSocket, POLLIN, 0 };
+
+        if (::poll(&fd, 1, timeoutMs) > 0)
+        {
+            // Drain everything that's waiting, stamping each datagram as it comes off the socket
+            for (;;)
+            {
+                const auto received = ::recv(listenSocket, buffer, sizeof(buffer), MSG_DONTWAIT);
+
+                if (received <= 0)
+                    break;
+
+                impairment.push(buffer, static_cast<size_t>(received), TransportClock::nowNs());
+            }
+        }
+
+        nowNs = TransportClock::nowNs();
+        impairment.release(nowNs, deliver);
+
+        if (nowNs >= nextReportNs)
+        {
+            report(nowNs);
+            nextReportNs += static_cast<uint64_t>(options.reportSeconds * 1.0e9);
+        }
+    }
+
+    if (driver != nullptr)
+        driver->stop();
+
+    report(TransportClock::nowNs());
+
+    if (csv != nullptr)
+        std::fclose(csv);
+
+    if (forwardSocket >= 0)
+        ::close(forwardSocket);
+
+    ::close(listenSocket);
+    return 0;
+}